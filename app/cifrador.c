@@ -24,20 +24,44 @@
  *   - T:  [Authentication tag]
  *   - T_: [Verification tag]
  * 
+ * Options:
+ *   - -m FILE: Write operation metrics in Prometheus text format to FILE
+ *              ("-" for stdout) once processing finishes
+ *   - -t FILE: Append one capture record per operation to trace FILE
+ *   - -H:      Include payload hashes in the capture records
+ * 
+ * Subcommands:
+ *   - bench MODE ...: Benchmark modes (see banco.c)
+ *   - gen ...:        Deterministic test-vector generator (see generador.c)
+ *   - llaves ...:     Pre-expanded key store (see almacen.c)
+ *   - enc|dec|rec ...: Parallel multi-file encryption and re-keying
+ *                     (see paralelo.c)
+ *   - act ...:        In-place update of a container (see paralelo.c)
+ *   - flujo ...:      Binary or hex stream encryption for pipelines (see flujo.c)
+ * 
  * Author: COFB-Midori64 Project
  * Date: December 2025
  * ============================================================================
  */
 
-#include"cofb.h"
+#include"banco.h"
+#include"generador.h"
+#include"almacen.h"
+#include"flujo.h"
+#include <unistd.h>
 
 /*
  * Function: main()
  * 
  * Purpose: Initializes cryptographic system and performs encryption/decryption
  * 
+ * Parameters:
+ *   - int argc: Number of command line arguments
+ *   - char *argv[]: Command line arguments (see Options above)
+ * 
  * Returns:
  *   - int: 0 on successful execution
+ *   - int: 1 on invalid options or when the metrics file cannot be written
  * 
  * Algorithm:
  *   1. Allocate memory for key, nonce, and ciphertext
@@ -47,7 +71,8 @@
  *   5. Encrypt: Call COFB(K, N) to get authentication tag T
  *   6. Decrypt: Call dCOFB(K, N, T) to recover plaintext and verify
  *   7. Display tags
- *   8. Return success
+ *   8. Export metrics if requested
+ *   9. Return success
  * 
  * Variables:
  *   - K[2]: 128-bit key split into two 64-bit blocks
@@ -56,7 +81,7 @@
  *   - T_: Authentication tag from decryption
  *   - Various legacy vectors (commented out)
  */
-int main()
+int main(int argc, char *argv[])
 	{
 	// Deprecated: Legacy string variables for user input
 	//cad cadK;
@@ -76,6 +101,78 @@ int main()
 	// Authentication tags
 	bloque T;	// Tag from encryption
 	bloque T_;	// Tag from decryption/verification
+	// Metrics output path (NULL when not requested)
+	cad rutaMet = NULL;
+	// Trace capture path, descriptor and current record
+	cad rutaTrz = NULL;
+	int fdTrz = -1;
+	registro R;
+	int opc;
+	
+	// ========================================================================
+	// COMMAND LINE OPTIONS
+	// ========================================================================
+	
+	if(argc > 1 && strcmp(argv[1],"bench") == 0)
+		{
+		return(banco(argc-1, argv+1));
+		}
+	if(argc > 1 && strcmp(argv[1],"gen") == 0)
+		{
+		return(generador(argc-1, argv+1));
+		}
+	if(argc > 1 && strcmp(argv[1],"llaves") == 0)
+		{
+		return(llaves(argc-1, argv+1));
+		}
+	if(argc > 1 && (strcmp(argv[1],"enc") == 0 || strcmp(argv[1],"dec") == 0))
+		{
+		return(paralelo(argc-1, argv+1, strcmp(argv[1],"enc") == 0 ? opCif : opDes));
+		}
+	if(argc > 1 && strcmp(argv[1],"rec") == 0)
+		{
+		return(paralelo(argc-1, argv+1, parRec));
+		}
+	if(argc > 1 && strcmp(argv[1],"act") == 0)
+		{
+		return(actualiza(argc-1, argv+1));
+		}
+	if(argc > 1 && strcmp(argv[1],"flujo") == 0)
+		{
+		return(flujo(argc-1, argv+1));
+		}
+	
+	while((opc = getopt(argc, argv, "m:t:H")) != -1)
+		{
+		switch(opc)
+			{
+			case 'm':
+				rutaMet = optarg;
+				break;
+			case 't':
+				rutaTrz = optarg;
+				break;
+			case 'H':
+				trzHash = 1;
+				break;
+			default:
+				fprintf(stderr,"Uso: %s [-m metricas.prom] [-t traza [-H]] < entrada\n",argv[0]);
+				fprintf(stderr,"     %s bench MODO ...\n",argv[0]);
+				fprintf(stderr,"     %s gen ...\n",argv[0]);
+				fprintf(stderr,"     %s llaves ...\n",argv[0]);
+				fprintf(stderr,"     %s enc|dec -k LLAVE [-j hilos] [-r] RUTA...\n",argv[0]);
+				fprintf(stderr,"     %s rec -k LLAVE -K NUEVA [-N estado] [-j hilos] [-r] RUTA...\n",argv[0]);
+				fprintf(stderr,"     %s act -k LLAVE -o DESPLAZAMIENTO [-i DATOS] [-N estado] CONTENEDOR\n",argv[0]);
+				fprintf(stderr,"     %s flujo [-d] [-x] -k LLAVE -n NONCE\n",argv[0]);
+				return(1);
+			}
+		}
+	
+	if(rutaTrz != NULL && (fdTrz = trzAbrir(rutaTrz)) < 0)
+		{
+		fprintf(stderr,"Error al abrir la traza %s\n",rutaTrz);
+		return(1);
+		}
 	
 	// ========================================================================
 	// KEY AND NONCE INPUT
@@ -103,7 +200,12 @@ int main()
 	
 	// Call COFB encryption mode
 	// Returns authentication tag T
+	trzIni(&R, opCif, K);
 	T = COFB(K,N);
+	if(fdTrz >= 0 && trzFin(fdTrz, &R) != 0)
+		{
+		fprintf(stderr,"Error al escribir la traza %s\n",rutaTrz);
+		}
 	
 	// Display authentication tag from encryption
 	printf("T: \t%016llx\n",T);
@@ -114,11 +216,26 @@ int main()
 	
 	// Call COFB decryption mode
 	// Returns computed authentication tag T_ for verification
+	trzIni(&R, opDes, K);
 	T_ = dCOFB(K,N,T);
+	if(fdTrz >= 0 && trzFin(fdTrz, &R) != 0)
+		{
+		fprintf(stderr,"Error al escribir la traza %s\n",rutaTrz);
+		}
 	
 	// Display computed tag from decryption
 	printf("T_: \t%016llx\n",T_);
 	
+	// ========================================================================
+	// METRICS EXPORT
+	// ========================================================================
+	
+	if(rutaMet != NULL && metEscribir(rutaMet) != 0)
+		{
+		fprintf(stderr,"Error al escribir las metricas en %s\n",rutaMet);
+		return(1);
+		}
+	
 	// ========================================================================
 	// LEGACY CODE (COMMENTED OUT)
 	// ========================================================================
@@ -34,9 +34,14 @@ echo "✔ Limpieza completa"
 
 echo "🔹 Construyendo Makefile..."
 # Set compiler flags for hardware acceleration:
-# -mavx2: Enable AVX2 SIMD instructions (vector operations)
 # -maes: Enable AES-NI hardware acceleration instructions
-export FLAGS_CC="-mavx2 -maes"
+# (SSSE3/AVX2 kernels carry their own target attributes and are chosen at
+# run time, so no -mavx2 here: the binary runs on any x86-64 CPU)
+export FLAGS_CC="-maes"
+# Libraries appended to the link line:
+# -lm: Math library (statistics of the benchmark modes)
+# -pthread: POSIX threads (pipelined I/O mode)
+export LIBS_CC="-lm -pthread"
 
 # Generate Makefile using makeMakefile.sh script
 # -c ./src/       : Source files directory
@@ -0,0 +1,44 @@
+#ifndef ALMACEN_H
+#define ALMACEN_H
+
+#include <cofb.h>
+
+#define almMagia	"CFBK"			//firma de un almacen de llaves
+#define almVer		0x02			//version del formato
+#define almOrden	0x0102030405060708	//marca del orden de bytes nativo
+#define almIndMin	0x10			//ranuras minimas del indice
+
+typedef struct CabAlmS{
+	char	 magia[4];	//almMagia
+	byte	 ver;		//almVer
+	byte	 band;		//banderas (reservado)
+	byte	 res[2];	//reservado, en cero
+	uint32_t tEnt;		//bytes por llave expandida
+	uint32_t res1;		//reservado, en cero
+	uint64_t orden;		//almOrden escrito con el orden nativo
+	uint64_t nInd;		//ranuras del indice (potencia de 2)
+	uint64_t nLlaves;	//llaves expandidas almacenadas
+	uint64_t sal;		//semilla aleatoria de la dispersion del indice
+	uint64_t res2[2];	//reservado, en cero
+	} cabAlm;
+
+typedef struct IndAlmS{
+	bloque	 K[2];		//llave maestra, comparada en cada busqueda
+	uint64_t pos;		//posicion de la llave + 1, 0 si esta libre
+	} indAlm;
+
+typedef struct AlmS{
+	void	 *m;		//proyeccion del archivo
+	size_t	  t;		//bytes proyectados
+	cabAlm	 *C;		//cabecera
+	indAlm	 *I;		//indice de dispersion
+	llaveExp *L;		//llaves expandidas
+	} almacen;
+
+byte almAbre(cad ruta, almacen *A);
+void almCierra(almacen *A);
+llaveExp * almBusca(almacen *A, bloques K);
+byte almEscribe(cad ruta, almacen *ant, bloques K, size_t t);
+int llaves(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef ARCHIVO_H
+#define ARCHIVO_H
+
+#include <cofb.h>
+
+#define arcStdio	0x00	//hexadecimal con fscanf()/fprintf()
+#define arcRW		0x01	//binario con read()/write() por trozos
+#define arcMmap		0x02	//binario con entrada y salida proyectadas
+#define arcHilos	0x03	//lector, cifrador y escritor en hilos
+#define arcUring	0x04	//binario con io_uring
+#define arcSplice	0x05	//binario, copia con splice() si no se cifra
+#define arcHex		0x06	//hexadecimal decodificado, cifrado y codificado por trozos
+#define nArc		0x07	//numero de modos de E/S
+
+#define arcTrozo	0x100000	//bytes por trozo de E/S
+#define arcRan		0x04		//trozos en vuelo de los modos asincronos
+#define arcTrozoHex	0x4000		//caracteres hex por trozo (cabe en L1/L2)
+
+#define arcOk		0x00	//archivo procesado
+#define arcError	0x01	//error de E/S
+#define arcNoDisp	0x02	//modo no disponible en este sistema
+
+typedef struct SalidaS{
+	int	 fd;		//descriptor de salida
+	bytes	 b;		//bufer de write()
+	size_t	 max;		//bytes maximos por emision
+	} salida;
+
+extern const char * nomArc[nArc];
+
+size_t leeTodo(int fd, bytes p, size_t t);
+byte escTodo(int fd, bytes p, size_t t);
+byte leeTodoEn(int fd, bytes p, size_t t, uint64_t off);
+byte escTodoEn(int fd, bytes p, size_t t, uint64_t off);
+byte salAbre(salida *S, int fd);
+bytes salPide(salida *S, size_t t);
+byte salEmite(salida *S, size_t t);
+void salCierra(salida *S);
+byte arcDeHex(const char *e, size_t l, bytes p, size_t *t, int *med);
+void arcAHex(const byte *p, char *s, size_t t);
+byte arcCifra(byte modo, int fdE, int fdS, uint64_t tam, cofbEdo *E);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef BANCO_H
+#define BANCO_H
+
+#include <archivo.h>
+#include <lote.h>
+#include <energia.h>
+
+#define maxPr	0x40	//pruebas maximas por configuracion
+
+typedef struct ResS{
+	char	 motor[0x10];	//motor de cifrado
+	char	 op[0x08];	//operacion ("enc", "dec")
+	uint64_t tam;		//bytes de mensaje por operacion
+	size_t	 t;		//numero de pruebas
+	double	 v[maxPr];	//rendimiento de cada prueba en MB/s
+	} resultado;
+
+int banco(int argc, char *argv[]);
+int bancoReplay(int argc, char *argv[]);
+int bancoRend(int argc, char *argv[]);
+int bancoFrio(int argc, char *argv[]);
+int bancoLat(int argc, char *argv[]);
+int bancoES(int argc, char *argv[]);
+int bancoSoak(int argc, char *argv[]);
+int bancoEnergia(int argc, char *argv[]);
+double percentil(double *v, size_t t, double p);
+double mannWhitney(double *x, size_t nx, double *y, size_t ny);
+double razonHL(double *x, size_t nx, double *y, size_t ny, double *inf, double *sup);
+
+#endif
@@ -1,14 +1,39 @@
 #ifndef COFB_H
 #define COFB_H
 
-#include <midori.h>
+#include <nucleo.h>
+#include <traza.h>
 
 static tn2 mx2;
 static tn2 mx2x3;
 static tn2 mx2x3x3;
 
+typedef struct EdoS{
+	llaveExp L;		//llave expandida
+	llaveNib X;		//llave desempacada (solo con mot == motNib)
+	bloque	 Y;		//estado del cifrado
+	bloque	 pend;		//ultimo bloque de mensaje aun sin encadenar
+	tn2	 mx;		//escalera de duplicaciones (mx2)
+	byte	 op;		//opCif u opDes
+	byte	 mot;		//motor de Midori (motRef o motNib)
+	byte	 hay;		//1 si pend contiene un bloque
+	uint64_t a;		//bloques de datos asociados
+	uint64_t m;		//bloques de mensaje
+	double	 t0;		//inicio de la operacion
+	} cofbEdo;
+
+extern byte cofbEsp;
+
 bloque COFB(bloques K, bloque N);
 bloque dCOFB(bloques K, bloque N, bloque T);
+bloque COFBbuf(bloques K, bloque N, bloques A, size_t a, bloques M, size_t m, bloques C);
+bloque dCOFBbuf(bloques K, bloque N, bloques A, size_t a, bloques C, size_t m, bloques M, bloque T);
+byte vCOFBbuf(bloques K, bloque N, bloques A, size_t a, bloques C, size_t m, bloques M, bloque T);
+void COFBini(cofbEdo *E, byte op, bloques K, bloque N, bloques A, size_t a);
+void COFBiniExp(cofbEdo *E, byte op, llaveExp *L, bloque N, bloques A, size_t a);
+void COFBsig(cofbEdo *E, bloques X, size_t m, bloques Z);
+void COFBtrans(cofbEdo *D, cofbEdo *E, bloques X, size_t m, bloques Z);
+bloque COFBfin(cofbEdo *E, bloque T);
 bloque maskGen(bloque Y0);
 tn2 gsuma(tn2 a, tn2 b);
 tn2 gdoble(tn2 a);
@@ -25,6 +50,7 @@ void xorBloqB(vect C, vect Y, vect M, byte j);
 void xorBloqBd(vect M, vect Y, vect C, byte j);
 void impVect(vect A);
 vect genVect(byte t);
+void libVect(vect A);
 cad leerEnt();
 vect cadToVect(cad A);
 
@@ -0,0 +1,35 @@
+#ifndef CONTENEDOR_H
+#define CONTENEDOR_H
+
+#include <archivo.h>
+
+#define ctnMagia	"CFBC"		//firma de un contenedor segmentado
+#define ctnVer		0x01		//version del formato
+#define ctnCab		0x20		//bytes de la cabecera
+#define ctnReg		0x10		//bytes de nonce y etiqueta por segmento
+#define ctnSegDef	0x10000		//bytes de texto claro por segmento (omision)
+#define ctnSegMax	0x4000000	//bytes de texto claro por segmento (maximo)
+#define ctnCtrDes	0x30		//desplazamiento del contador de escrituras en el nonce
+#define ctnCtrMax	0xffff		//escrituras maximas de un segmento
+#define ctnBaseMsk	0xffffffffffff	//bits del nonce que numeran segmentos
+
+typedef struct CtnS{
+	uint32_t tSeg;		//bytes de texto claro por segmento (multiplo de 8)
+	uint64_t lon;		//bytes de texto claro
+	bloque	 base;		//nonce del segmento 0 (contador de escrituras en 0)
+	uint64_t nSeg;		//numero de segmentos (al menos 1)
+	} contenedor;
+
+void ctnIni(contenedor *C, uint32_t tSeg, uint64_t lon, bloque base);
+void ctnPonCab(contenedor *C, bytes p);
+byte ctnLeeCab(bytes p, uint64_t tam, contenedor *C);
+uint64_t ctnLonSeg(contenedor *C, uint64_t i);
+uint64_t ctnOff(contenedor *C, uint64_t i);
+uint64_t ctnTam(contenedor *C);
+bloque ctnNonce(contenedor *C, uint64_t i, uint64_t ctr);
+void ctnCifraSeg(llaveExp *L, contenedor *C, uint64_t i, bloque N, bytes e, bytes reg, bloques B);
+byte ctnDescifraSeg(llaveExp *L, contenedor *C, uint64_t i, bytes reg, bytes s, bloques B);
+byte ctnRecifraSeg(llaveExp *Lv, llaveExp *Ln, contenedor *C, uint64_t i, bloque Nn, bytes reg, bytes sal, bloques B);
+bloque ctnAleat();
+
+#endif
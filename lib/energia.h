@@ -0,0 +1,28 @@
+#ifndef ENERGIA_H
+#define ENERGIA_H
+
+#include <misc.h>
+
+#define eneRaiz		"/sys/class/powercap"	//interfaz powercap de Linux
+#define enePaq		0x00	//dominio package (todo el encapsulado)
+#define eneNuc		0x01	//dominio core (PP0, solo los nucleos)
+#define eneDoms		0x02	//numero de dominios medidos
+#define eneZonas	0x10	//zonas RAPL maximas
+
+typedef struct ZonaS{
+	char	 ruta[0x100];	//archivo energy_uj
+	uint64_t max;		//max_energy_range_uj (el contador vuelve a 0 al pasarlo)
+	byte	 dom;		//enePaq o eneNuc
+	} zonaR;
+
+typedef struct RaplS{
+	zonaR	 z[eneZonas];	//zonas legibles
+	size_t	 t;		//numero de zonas
+	byte	 hay[eneDoms];	//1 si algun paquete aporta el dominio
+	} rapl;
+
+byte raplAbre(rapl *R, cad raiz);
+byte raplLee(rapl *R, uint64_t *e);
+void raplJulios(rapl *R, uint64_t *e0, uint64_t *e1, double *J);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef FLUJO_H
+#define FLUJO_H
+
+#include <paralelo.h>
+
+#define fluPad		0x80	//primer byte del relleno 10*
+
+int flujo(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef GENERADOR_H
+#define GENERADOR_H
+
+#include <cofb.h>
+
+#define genMagia	"CFBV"	//firma de un archivo binario de vectores
+#define genVer		0x01	//version del formato binario
+#define genCab		0x05	//bytes de la cabecera (firma + version)
+
+#define distFija	0x00	//tamano constante
+#define distUnif	0x01	//tamano uniforme en [min, max]
+#define distMezcla	0x02	//mezcla de tamanos de paquetes reales
+
+typedef struct DistS{
+	byte	 tipo;		//distFija, distUnif o distMezcla
+	uint64_t min;		//bloques minimos
+	uint64_t max;		//bloques maximos
+	} dist;
+
+byte leeDist(cad s, dist *D);
+uint64_t muestraDist(dist *D, bloque *edo);
+int generador(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <nucleo.h>
+
+#define loteMax		0x10	//bloques por pasada (carriles de 16 bits de un registro AVX2)
+#define loteEsc		0x00	//planos en palabras de 64 bits, sin SIMD
+#define loteSSE2	0x01	//planos en registros XMM
+#define loteAVX2	0x02	//planos en registros YMM
+#define nLote		0x03	//numero de nucleos por lotes
+
+typedef struct LlaveLS{
+	uint16_t WK[4][loteMax] __attribute__((aligned(32)));	//planos del blanqueo inicial
+	uint16_t RK[r-1][4][loteMax];	//planos de las llaves de ronda (con la constante de Sb0)
+	uint16_t WF[4][loteMax];	//planos del blanqueo final (con la constante de Sb0)
+	} llaveLote;
+
+extern byte loteMot;
+extern const char * nomLote[nLote];
+
+byte hayLote(byte mot);
+void desempacaLote(llaveLote *X, llaveExp *L);
+void midoriLote(llaveLote *X, bloques S, size_t t, bloques Y);
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * ============================================================================
+ * File: loteCuerpo.h
+ * Purpose: Batch Midori-64 kernel body, one instance per instruction set
+ *
+ * Deliberately without an include guard: lote.c includes this file once
+ * after each inclusion of simd.h, which gives every function below its
+ * instruction set suffix (e.g. loteRondas_sse2) and target attribute.
+ *
+ * State: four bit planes per block, plane k holding bit k of the 16
+ * nibbles as one 16-bit lane in the layout described in lote.c. A vector
+ * carries vBytes / 2 blocks; the constants (lotCte) and the key planes
+ * (llaveLote) are stored replicated, so plain loads broadcast them.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+/*
+ * Function: loteSb()
+ *
+ * Purpose: SubCell on the four planes (Sb0 as a 17-gate circuit)
+ *
+ * Parameters:
+ *   - vT *x: Planes 0 to 3, replaced by the S-box output
+ *
+ * Details: Algebraic normal form of Sb0 with a = x0, b = x1, c = x2,
+ *          d = x3:
+ *            y0 = b ^ ac ^ ad ^ abc ^ abd ^ bcd
+ *            y1 = a ^ c ^ ac ^ ad ^ cd
+ *            y2 = 1 ^ a ^ d ^ ad ^ abc ^ abd ^ bcd
+ *            y3 = 1 ^ ab ^ bd ^ abd ^ cd ^ bcd
+ *          The constant 1 of y2 and y3 is not applied here: it crosses
+ *          ShuffleCell and MixColumn unchanged and is folded into the
+ *          round keys by desempacaLote()
+ */
+static inline simdAtrib void simdNombre(loteSb)(vT *x)
+	{
+	vT f  = vAnd(x[0], vXor(x[2], x[3]));	// ac ^ ad
+	vT g  = vAnd(x[1], f);			// abc ^ abd
+	vT cd = vAnd(x[2], x[3]);
+	vT h  = vAnd(x[1], cd);			// bcd
+	vT o  = vOr(x[0], x[3]);		// a ^ d ^ ad
+	vT gh = vXor(g, h);
+	vT y1 = vXor(vXor(x[0], x[2]), vXor(f, cd));
+
+	x[0] = vXor(vXor(x[1], f), gh);
+	x[3] = vXor(vXor(vAnd(x[1], o), cd), h);
+	x[2] = vXor(o, gh);
+	x[1] = y1;
+	return;
+	}
+
+/*
+ * Function: lotePerm()
+ *
+ * Purpose: ShuffleCell on one plane
+ *
+ * Details: With the lote.c layout the 16 cell moves reduce to six shift
+ *          distances (0, +2, +4, +10, -6, -10), one mask each
+ */
+static inline simdAtrib vT simdNombre(lotePerm)(vT x)
+	{
+	return(vOr(vOr(vOr(vAnd(x, vCarga(lotCte[ctP0])),
+			vAnd(vShl(x, 2), vCarga(lotCte[ctP2]))),
+		vOr(vAnd(vShl(x, 4), vCarga(lotCte[ctP4])),
+			vAnd(vShl(x, 10), vCarga(lotCte[ctP10])))),
+		vOr(vAnd(vShr(x, 6), vCarga(lotCte[ctQ6])),
+			vAnd(vShr(x, 10), vCarga(lotCte[ctQ10])))));
+	}
+
+/*
+ * Function: loteMezcla()
+ *
+ * Purpose: MixColumn on one plane
+ *
+ * Details: Columns are groups of four adjacent bits, and each output is
+ *          the XOR of the other three cells of its column:
+ *          s1 swaps neighbours (x^1), then s1 ^ swap2(y ^ s1) adds the
+ *          cells x^2 and x^3
+ */
+static inline simdAtrib vT simdNombre(loteMezcla)(vT y)
+	{
+	vT m1 = vCarga(lotCte[ctS1]);
+	vT m2 = vCarga(lotCte[ctS2]);
+	vT s1 = vOr(vAnd(vShr(y, 1), m1), vShl(vAnd(y, m1), 1));
+	vT t  = vXor(y, s1);
+
+	return(vXor(s1, vOr(vAnd(vShr(t, 2), m2), vShl(vAnd(t, m2), 2))));
+	}
+
+/*
+ * Function: loteRondas()
+ *
+ * Purpose: Encrypts blocks held as bit planes
+ *
+ * Parameters:
+ *   - llaveLote *X: Key planes from desempacaLote()
+ *   - uint16_t *pl: Planes (4 rows of loteMax lanes), replaced in place
+ *   - size_t nv: Number of vectors per plane to process
+ *
+ * Returns: void
+ */
+static simdAtrib void simdNombre(loteRondas)(llaveLote *X, uint16_t *pl, size_t nv)
+	{
+	size_t v;
+	byte i;
+	byte k;
+	vT x[4];
+	uint16_t *q;
+
+	for(v=0;v<nv;v++)
+		{
+		q = pl + v * (vBytes / 2);
+		for(k=0;k<4;k++)
+			{
+			x[k] = vXor(vCarga(q + k * loteMax), vCarga(X->WK[k]));
+			}
+		for(i=0;i<=r-2;i++)
+			{
+			simdNombre(loteSb)(x);
+			for(k=0;k<4;k++)
+				{
+				x[k] = vXor(simdNombre(loteMezcla)(simdNombre(lotePerm)(x[k])), vCarga(X->RK[i][k]));
+				}
+			}
+		simdNombre(loteSb)(x);
+		for(k=0;k<4;k++)
+			{
+			vGuarda(q + k * loteMax, vXor(x[k], vCarga(X->WF[k])));
+			}
+		}
+	return;
+	}
@@ -0,0 +1,31 @@
+#ifndef METRICAS_H
+#define METRICAS_H
+
+#include <midori.h>
+#include <time.h>
+
+#define opCif	0x00	//operacion de cifrado
+#define opDes	0x01	//operacion de descifrado
+#define nOps	0x02	//numero de tipos de operacion
+#define nCub	0x0c	//numero de limites finitos del histograma de latencia
+
+typedef struct MetS{
+	uint64_t ops[nOps];		//operaciones completadas
+	uint64_t bloqA[nOps];		//bloques de datos asociados procesados
+	uint64_t bloqM[nOps];		//bloques de mensaje procesados
+	uint64_t fallas;		//etiquetas que no verificaron
+	uint64_t cub[nOps][nCub+1];	//histograma de latencia (no acumulado)
+	double	 sumLat[nOps];		//suma de latencias en segundos
+	} metricas;
+
+extern const double limCub[nCub];
+
+double metReloj();
+metricas * metPropias();
+void metOp(byte op, double t0, uint64_t a, uint64_t m);
+void metFalla();
+void metTotal(metricas *T);
+void metImpProm(FILE *f);
+byte metEscribir(cad ruta);
+
+#endif
@@ -41,6 +41,11 @@ typedef uint16_t 	dbyte;
 typedef uint8_t 	nibble;
 typedef uint8_t 	byte;	
 
+typedef struct LlaveS{
+	bloque	WK;		//llave de blanqueo
+	bloque	RK[r];		//llaves de ronda (RK[r-1] sin uso, en cero)
+	} llaveExp;
+
 nibble obtNibble(bloque S, nibble pos);
 bloque asgNibble(bloque S, byte pos, nibble val);
 bloque keyGen(bloque RK[r], bloque Ki[2]);
@@ -49,5 +54,8 @@ bloque subCell(bloque S);
 bloque shuffleCell(bloque S, byte inv);
 bloque mixColumn(bloque S);
 bloque midori(bloque S, bloque Ki[2], byte inv);
+void expandeLlave(llaveExp *L, bloque Ki[2]);
+bloque midoriExp(bloque S, llaveExp *L, byte inv);
+const void * midoriTablas(size_t *t);
 
 #endif
@@ -25,5 +25,34 @@ byte techo(double a);
 void impBin(tn2 num);
 tn2 leeBin(cad a);
 bloque reverse(bloque a);
+bloque aleat(bloque *edo);
+void cargaBEs(const byte *p, bloques B, size_t m);
+void guardaBEs(bloques B, byte *p, size_t m);
+
+/*
+ * Big-endian load and store of one block: p[0] is the most significant
+ * byte. Defined here so every caller inlines them; a fixed-size memcpy
+ * plus __builtin_bswap64 compiles to a single load or store with bswap
+ * (or movbe), and to nothing extra on big-endian targets.
+ */
+static inline bloque cargaBE(const byte *p)
+	{
+	bloque x;
+
+	memcpy(&x, p, sizeof(bloque));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	x = __builtin_bswap64(x);
+#endif
+	return(x);
+	}
+
+static inline void guardaBE(byte *p, bloque x)
+	{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	x = __builtin_bswap64(x);
+#endif
+	memcpy(p, &x, sizeof(bloque));
+	return;
+	}
 
 #endif
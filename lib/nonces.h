@@ -0,0 +1,32 @@
+#ifndef NONCES_H
+#define NONCES_H
+
+#include <archivo.h>
+#include <pthread.h>
+
+#define nonMagia	"CFBN"		//firma del archivo de estado
+#define nonVer		0x01		//version del formato
+#define nonCab		0x10		//bytes del archivo de estado
+#define nonTrozo	0x100000	//nonces por arriendo
+#define nonAvance	0x10000000	//nonces reservados por cada escritura del estado
+
+typedef struct GestorS{
+	uint64_t sig __attribute__((aligned(64)));	//siguiente nonce sin arrendar (atomico)
+	uint64_t tope __attribute__((aligned(64)));	//limite persistido, exclusivo (atomico)
+	uint64_t lim;		//fin del espacio de nonces, exclusivo
+	int	 fd;		//archivo de estado, -1 sin persistencia
+	pthread_mutex_t m;	//serializa las escrituras del estado
+	} gestorN;
+
+typedef struct ArriendoS{
+	gestorN	*G;		//gestor del que se arrienda
+	uint64_t a;		//siguiente nonce del arriendo
+	uint64_t b;		//fin del arriendo, exclusivo
+	} arriendo;
+
+byte nonAbre(gestorN *G, cad ruta, uint64_t ini, uint64_t lim);
+void nonCierra(gestorN *G);
+void nonIniArr(arriendo *R, gestorN *G);
+byte nonPide(arriendo *R, uint64_t k, bloque *N);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef NUCLEO_H
+#define NUCLEO_H
+
+#include <midori.h>
+
+#define motRef	0x00	//motor de referencia (midoriExp, nibble a nibble)
+#define motNib	0x01	//motor SSSE3 de un bloque (un nibble por byte)
+#define nMot	0x02	//numero de motores
+#define maxTab	0x05	//tablas de consulta reportadas por nucTablas
+
+typedef struct LlaveNS{
+	byte	WK[nxn] __attribute__((aligned(16)));	//llave de blanqueo desempacada
+	byte	RK[r][nxn] __attribute__((aligned(16)));	//llaves de ronda desempacadas
+	} llaveNib;
+
+extern byte nucMot;
+extern const char * nomMot[nMot];
+
+byte hayMot(byte mot);
+void desempacaLlave(llaveNib *X, llaveExp *L);
+bloque midoriNib(bloque S, llaveNib *X);
+byte nucTablas(const void *p[maxTab], size_t t[maxTab]);
+
+#endif
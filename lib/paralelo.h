@@ -0,0 +1,69 @@
+#ifndef PARALELO_H
+#define PARALELO_H
+
+#include <contenedor.h>
+#include <nonces.h>
+
+#define parExt		".cfb"		//extension de los contenedores
+#define parTmp		".tmp"		//sufijo de la salida temporal al recifrar
+#define parRec		0x02		//operacion de recifrado (ademas de opCif y opDes)
+#define parLoteMax	0x40		//archivos chicos por tarea
+#define parLoteTam	0x100000	//bytes de archivos chicos por tarea
+#define parSegTarea	0x10		//segmentos de un archivo grande por tarea
+#define parHilosMax	0x100		//hilos de trabajo maximos
+
+typedef struct ArchS{
+	cad	   e;		//ruta de entrada
+	cad	   s;		//ruta de salida
+	uint64_t   tam;		//bytes de la entrada
+	contenedor C;		//descripcion del contenedor (archivos grandes)
+	int	   fdE;		//entrada abierta (archivos grandes)
+	int	   fdS;		//salida abierta (archivos grandes)
+	bytes	   mS;		//proyeccion de la salida (escritor mmap)
+	size_t	   tS;		//bytes de la salida
+	byte	   err;		//1 si el archivo fallo
+	} arch;
+
+typedef struct TareaS{
+	size_t	 a;		//primer archivo
+	size_t	 nA;		//archivos chicos del lote, 0 si son segmentos
+	uint64_t s0;		//primer segmento (archivos grandes)
+	uint64_t s1;		//segmento final, exclusivo (archivos grandes)
+	} tarea;
+
+typedef struct TrabS{
+	arch	*F;		//archivos
+	size_t	 nF;
+	tarea	*T;		//tareas
+	size_t	 nT;
+	size_t	 sig;		//siguiente tarea libre (atomico)
+	llaveExp L;		//llave expandida (la anterior al recifrar)
+	llaveExp Ln;		//llave nueva expandida (recifrado)
+	byte	 op;		//opCif, opDes o parRec
+	byte	 mmapS;		//1 para el escritor mmap, 0 para pwrite
+	byte	 forzar;	//1 para sobrescribir salidas existentes
+	uint32_t tSeg;		//bytes por segmento al cifrar
+	gestorN	*G;		//gestor de nonces (cifrado)
+	} trabajo;
+
+typedef struct ActS{
+	int	  fd;		//contenedor abierto para lectura y escritura
+	bloque	  base;		//nonce del primer segmento nuevo al crecer
+	llaveExp *L;		//llave expandida
+	contenedor V;		//contenedor antes de la escritura
+	contenedor C;		//contenedor despues de la escritura
+	uint64_t  off;		//primer byte escrito
+	bytes	  d;		//bytes escritos
+	uint64_t  t;
+	uint64_t  s0;		//primer segmento afectado
+	uint64_t  s1;		//segmento afectado final, exclusivo
+	uint64_t  sig;		//siguiente grupo de segmentos libre (atomico)
+	byte	  err;		//1 si algun segmento fallo (atomico)
+	} actual;
+
+byte leeLlave(cad ruta, bloques K);
+int paralelo(int argc, char *argv[], byte op);
+byte parActualiza(cad ruta, llaveExp *L, arriendo *R, uint64_t off, bytes d, uint64_t t, size_t nH);
+int actualiza(int argc, char *argv[]);
+
+#endif
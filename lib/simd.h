@@ -0,0 +1,112 @@
+/*
+ * ============================================================================
+ * File: simd.h
+ * Purpose: Thin vector abstraction for the batch Midori kernels
+ *
+ * Deliberately without an include guard: lote.c includes this header
+ * once per instruction set, each time after setting simdISA, and then
+ * instantiates loteCuerpo.h with the resulting definitions. Every
+ * operation works on the full register as independent 64-bit lanes:
+ *
+ *   vT            vector type
+ *   vBytes        bytes per vector
+ *   vCarga(p)     aligned load (p aligned to vBytes)
+ *   vGuarda(p,x)  aligned store
+ *   vXor, vAnd, vOr
+ *   vShl(x,d), vShr(x,d)  shift of each 64-bit lane by a constant
+ *   simdAtrib     function attribute enabling the instruction set
+ *   simdNombre(f) f with the instruction set suffix appended
+ *
+ * Constants are kept in memory already replicated to the widest vector,
+ * so a plain vCarga() doubles as a broadcast.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#define simdEsc		0x01	//palabras de 64 bits sin SIMD
+#define simdSSE2	0x02	//registros XMM (base de x86-64)
+#define simdAVX2	0x03	//registros YMM
+
+#undef vT
+#undef vBytes
+#undef vCarga
+#undef vGuarda
+#undef vXor
+#undef vAnd
+#undef vOr
+#undef vShl
+#undef vShr
+#undef simdAtrib
+#undef simdSufijo
+
+#define simdPega(f,s)	f##_##s
+#define simdPega2(f,s)	simdPega(f,s)
+#define simdNombre(f)	simdPega2(f,simdSufijo)
+
+#if simdISA == simdEsc
+
+#ifndef SIMD_ESC
+#define SIMD_ESC
+// Planes are uint16_t arrays; memcpy keeps the 64-bit access well defined
+static inline uint64_t simdCarga64(const void *p)
+	{
+	uint64_t x;
+
+	memcpy(&x, p, sizeof(x));
+	return(x);
+	}
+
+static inline void simdGuarda64(void *p, uint64_t x)
+	{
+	memcpy(p, &x, sizeof(x));
+	return;
+	}
+#endif
+
+#define vT		uint64_t
+#define vBytes		0x08
+#define vCarga(p)	simdCarga64(p)
+#define vGuarda(p,x)	simdGuarda64((p), (x))
+#define vXor(a,b)	((a) ^ (b))
+#define vAnd(a,b)	((a) & (b))
+#define vOr(a,b)	((a) | (b))
+#define vShl(a,d)	((a) << (d))
+#define vShr(a,d)	((a) >> (d))
+#define simdAtrib
+#define simdSufijo	esc
+
+#elif simdISA == simdSSE2
+
+#include <emmintrin.h>
+#define vT		__m128i
+#define vBytes		0x10
+#define vCarga(p)	_mm_load_si128((const __m128i *)(p))
+#define vGuarda(p,x)	_mm_store_si128((__m128i *)(p), (x))
+#define vXor(a,b)	_mm_xor_si128((a), (b))
+#define vAnd(a,b)	_mm_and_si128((a), (b))
+#define vOr(a,b)	_mm_or_si128((a), (b))
+#define vShl(a,d)	_mm_slli_epi64((a), (d))
+#define vShr(a,d)	_mm_srli_epi64((a), (d))
+#define simdAtrib	__attribute__((target("sse2")))
+#define simdSufijo	sse2
+
+#elif simdISA == simdAVX2
+
+#include <immintrin.h>
+#define vT		__m256i
+#define vBytes		0x20
+#define vCarga(p)	_mm256_load_si256((const __m256i *)(p))
+#define vGuarda(p,x)	_mm256_store_si256((__m256i *)(p), (x))
+#define vXor(a,b)	_mm256_xor_si256((a), (b))
+#define vAnd(a,b)	_mm256_and_si256((a), (b))
+#define vOr(a,b)	_mm256_or_si256((a), (b))
+#define vShl(a,d)	_mm256_slli_epi64((a), (d))
+#define vShr(a,d)	_mm256_srli_epi64((a), (d))
+#define simdAtrib	__attribute__((target("avx2")))
+#define simdSufijo	avx2
+
+#else
+#error "simdISA desconocido"
+#endif
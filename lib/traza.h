@@ -0,0 +1,38 @@
+#ifndef TRAZA_H
+#define TRAZA_H
+
+#include <metricas.h>
+
+#define trzMagia	"CFBT"	//firma de un archivo de traza
+#define trzVer		0x02	//version del formato de traza
+#define trzCab		0x0d	//bytes de la cabecera (firma + version + sal)
+#define trzVer1		0x01	//version 1: sin sal, identificadores FNV-1a
+#define trzCab1		0x05	//bytes de la cabecera de la version 1 (sin sal)
+#define trzMaxReg	0x38	//bytes maximos de un registro codificado
+#define trzConH		0x01	//bandera: el registro incluye hash de la carga
+
+typedef struct RegS{
+	byte	 op;		//tipo de operacion (opCif, opDes)
+	byte	 band;		//banderas del registro (trzConH)
+	uint64_t t;		//llegada en ns (CLOCK_REALTIME)
+	uint64_t llave;		//identificador seudonimo de la llave (trzLlave)
+	uint64_t a;		//bloques de datos asociados
+	uint64_t m;		//bloques de mensaje
+	uint64_t dur;		//tiempo de servicio en ns
+	uint64_t hash;		//hash FNV-1a de la carga de entrada
+	} registro;
+
+extern byte	trzHash;
+extern bloque	trzAcumH;
+extern bloque	trzSal;
+
+uint64_t trzReloj();
+bloque trzFnv(bloque h, bloque B);
+bloque trzLlave(bloques K);
+void trzAcum(bloque B);
+int trzAbrir(cad ruta);
+void trzIni(registro *R, byte op, bloques K);
+byte trzFin(int fd, registro *R);
+registro * trzLeer(cad ruta, size_t *t);
+
+#endif
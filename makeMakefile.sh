@@ -229,6 +229,10 @@ do
 	concat=$concat"\$(OBJ_DIR)/$obj "
 done
 concat=$concat"\n\n$argsB : \$(ALL_OBJ)\n"
-concat=$concat"\tcc $FLAGS_CC -o $argsB \$(ALL_OBJ)"
+concat=$concat"\tcc $FLAGS_CC -o $argsB \$(ALL_OBJ) $LIBS_CC"
+
+### OBJETIVO DE PRUEBAS (probar.sh) ###################
+concat=$concat"\n\ntest :\n\tmkdir -p $(dirname $argsB) \$(OBJ_DIR)\n\t\$(MAKE) $argsB\n\t./probar.sh $argsB"
+concat=$concat"\n\n.PHONY : test"
 echo $concat > Makefile
 #######################################################
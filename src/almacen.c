@@ -0,0 +1,545 @@
+/*
+ * ============================================================================
+ * File: almacen.c
+ * Purpose: Persistent store of pre-expanded Midori-64 keys
+ *
+ * A process that serves many keys would otherwise run keyGen() once per
+ * key at startup. The store keeps the expanded schedules (llaveExp) in a
+ * file laid out exactly as in memory, so it is mapped read-only and a
+ * key costs a page fault on first use instead of a key expansion.
+ *
+ * File Format (native byte order, checked through the orden field):
+ *   Header: cabAlm (64 bytes)
+ *   Index:  nInd x indAlm, open addressing with linear probing on an
+ *           FNV-1a hash of the key seeded with the random salt of the
+ *           header; each slot holds the key itself, so a lookup never
+ *           returns the schedule of a colliding key
+ *   Keys:   nLlaves x llaveExp, dense, in insertion order
+ *
+ * Updates are copy-on-write: a complete new file is written next to the
+ * old one, synced and renamed over it. Processes that mapped the old
+ * file keep a consistent view until they reopen it.
+ *
+ * Expanded keys reveal the master key, so the store is created with mode
+ * 0600 and must be protected like the keys themselves.
+ *
+ * A damaged index cannot send a lookup out of the mapping: probes stop
+ * after nInd slots and key positions are checked against nLlaves before
+ * use. "llaves info" walks the whole index and reports any such entry.
+ *
+ * Invoked as "cifrador llaves crear|agregar|info|buscar ...".
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"almacen.h"
+#include <paralelo.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+
+/*
+ * Function: tamAlm()
+ *
+ * Purpose: Bytes of a store with the given index and key counts
+ */
+static size_t tamAlm(uint64_t nInd, uint64_t nLlaves)
+	{
+	return(sizeof(cabAlm) + nInd * sizeof(indAlm) + nLlaves * sizeof(llaveExp));
+	}
+
+/*
+ * Function: dispersa()
+ *
+ * Purpose: Index hash of a key
+ *
+ * Parameters:
+ *   - bloque sal: Salt of the store (cabAlm.sal)
+ *   - bloques K: 128-bit key (array of 2 blocks)
+ *
+ * Returns:
+ *   - bloque: FNV-1a of both key halves, seeded with the salt
+ */
+static bloque dispersa(bloque sal, bloques K)
+	{
+	return(trzFnv(trzFnv(sal, K[0]), K[1]));
+	}
+
+/*
+ * Function: almAbre()
+ *
+ * Purpose: Maps a key store read-only
+ *
+ * Parameters:
+ *   - cad ruta: Path of the store
+ *   - almacen *A: Mapped store (output)
+ *
+ * Returns:
+ *   - 0: Store mapped and validated
+ *   - 1: Missing file, I/O error or invalid store
+ *
+ * Details: Nothing is read besides the header; index and key pages are
+ *          faulted in on first lookup, where each slot is validated
+ */
+byte almAbre(cad ruta, almacen *A)
+	{
+	int fd;
+	struct stat st;
+
+	memset(A, 0, sizeof(almacen));
+	fd = open(ruta, O_RDONLY);
+	if(fd < 0)
+		{
+		return(1);
+		}
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(cabAlm))
+		{
+		close(fd);
+		return(1);
+		}
+	A->t = (size_t)st.st_size;
+	A->m = mmap(NULL, A->t, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(A->m == MAP_FAILED)
+		{
+		A->m = NULL;
+		return(1);
+		}
+	A->C = (cabAlm *)A->m;
+	A->I = (indAlm *)(A->C + 1);
+	A->L = (llaveExp *)(A->I + A->C->nInd);
+	if(memcmp(A->C->magia, almMagia, 4) != 0 || A->C->ver != almVer || A->C->orden != almOrden
+		|| A->C->tEnt != sizeof(llaveExp) || A->C->nInd < almIndMin || A->C->nInd > A->t / sizeof(indAlm)
+		|| (A->C->nInd & (A->C->nInd - 1)) != 0 || A->C->nLlaves >= A->C->nInd
+		|| tamAlm(A->C->nInd, A->C->nLlaves) > A->t)
+		{
+		almCierra(A);
+		return(1);
+		}
+	madvise(A->m, A->t, MADV_RANDOM);
+	return(0);
+	}
+
+/*
+ * Function: almCierra()
+ *
+ * Purpose: Unmaps a store opened with almAbre()
+ */
+void almCierra(almacen *A)
+	{
+	if(A->m != NULL)
+		{
+		munmap(A->m, A->t);
+		}
+	memset(A, 0, sizeof(almacen));
+	return;
+	}
+
+/*
+ * Function: ranura()
+ *
+ * Purpose: Finds the index slot of a key, or the free slot where it
+ *          would be inserted
+ *
+ * Parameters:
+ *   - indAlm *I: Index
+ *   - uint64_t nInd: Index slots (power of 2)
+ *   - bloque sal: Salt of the store
+ *   - bloques K: 128-bit key
+ *
+ * Returns:
+ *   - indAlm *: Slot holding K, or the first free slot of its probe run;
+ *               NULL if every slot is taken by other keys
+ */
+static indAlm * ranura(indAlm *I, uint64_t nInd, bloque sal, bloques K)
+	{
+	uint64_t i = dispersa(sal, K) & (nInd - 1);
+	uint64_t j;
+
+	for(j=0;j<nInd;j++)
+		{
+		if(I[i].pos == 0 || (I[i].K[0] == K[0] && I[i].K[1] == K[1]))
+			{
+			return(&I[i]);
+			}
+		i = (i + 1) & (nInd - 1);
+		}
+	return(NULL);
+	}
+
+/*
+ * Function: almBusca()
+ *
+ * Purpose: Looks up the expanded key of a master key
+ *
+ * Parameters:
+ *   - almacen *A: Store opened with almAbre()
+ *   - bloques K: 128-bit key (array of 2 blocks)
+ *
+ * Returns:
+ *   - llaveExp *: Expanded key inside the mapping (valid until
+ *                 almCierra()), or NULL if the key is not stored or its
+ *                 slot points past the stored keys
+ */
+llaveExp * almBusca(almacen *A, bloques K)
+	{
+	indAlm *x = ranura(A->I, A->C->nInd, A->C->sal, K);
+
+	if(x == NULL || x->pos == 0 || x->pos > A->C->nLlaves)
+		{
+		return(NULL);
+		}
+	return(&A->L[x->pos - 1]);
+	}
+
+/*
+ * Function: sincDir()
+ *
+ * Purpose: Syncs the directory holding a path, making a rename durable
+ */
+static byte sincDir(cad ruta)
+	{
+	char tmp[0x400];
+	int fd;
+	byte err;
+
+	snprintf(tmp, sizeof(tmp), "%s", ruta);
+	fd = open(dirname(tmp), O_RDONLY);
+	if(fd < 0)
+		{
+		return(1);
+		}
+	err = fsync(fd) != 0;
+	close(fd);
+	return(err);
+	}
+
+/*
+ * Function: almEscribe()
+ *
+ * Purpose: Writes a store with the keys of an old store plus new keys
+ *
+ * Parameters:
+ *   - cad ruta: Path of the store to create or replace
+ *   - almacen *ant: Store whose keys are carried over, or NULL
+ *   - bloques K: New keys (2 blocks each)
+ *   - size_t t: Number of new keys
+ *
+ * Returns:
+ *   - 0: New store in place
+ *   - 1: I/O error or damaged old store (the previous file, if any, is
+ *        untouched)
+ *
+ * Algorithm:
+ *   1. Size the index for a load factor of at most 3/4 and draw a new
+ *      salt for it
+ *   2. Map "<ruta>.tmp" and rehash the old entries, then expand and add
+ *      the new keys that are not stored yet
+ *   3. Trim the unused tail, fsync, rename over ruta, fsync the directory
+ */
+byte almEscribe(cad ruta, almacen *ant, bloques K, size_t t)
+	{
+	char tmp[0x400];
+	uint64_t nAnt = ant != NULL ? ant->C->nLlaves : 0;
+	uint64_t tot = nAnt + t;
+	uint64_t nInd = almIndMin;
+	uint64_t i;
+	size_t tam;
+	int fd;
+	byte *m;
+	cabAlm *C;
+	indAlm *I;
+	indAlm *x;
+	llaveExp *L;
+	bloque sal;
+	byte err = 0;
+
+	while(nInd - (nInd >> 2) <= tot)
+		{
+		nInd <<= 1;
+		}
+	if(getrandom(&sal, sizeof(sal), 0) != sizeof(sal))
+		{
+		return(1);
+		}
+	tam = tamAlm(nInd, tot);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", ruta);
+	fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if(fd < 0)
+		{
+		return(1);
+		}
+	if(ftruncate(fd, (off_t)tam) != 0
+		|| (m = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		{
+		close(fd);
+		unlink(tmp);
+		return(1);
+		}
+	C = (cabAlm *)m;
+	I = (indAlm *)(C + 1);
+	L = (llaveExp *)(I + nInd);
+
+	// The file was just extended with zeros, so the index starts empty
+	memcpy(C->magia, almMagia, 4);
+	C->ver		= almVer;
+	C->tEnt		= sizeof(llaveExp);
+	C->orden	= almOrden;
+	C->nInd		= nInd;
+	C->nLlaves	= 0;
+	C->sal		= sal;
+
+	// Old slots are trusted only as far as they stay inside the old store
+	for(i=0;i<(ant != NULL ? ant->C->nInd : 0) && err == 0;i++)
+		{
+		if(ant->I[i].pos != 0)
+			{
+			x = C->nLlaves < tot ? ranura(I, nInd, sal, ant->I[i].K) : NULL;
+			err = x == NULL || ant->I[i].pos > nAnt;
+			if(err == 0 && x->pos == 0)
+				{
+				L[C->nLlaves] = ant->L[ant->I[i].pos - 1];
+				x->K[0] = ant->I[i].K[0];
+				x->K[1] = ant->I[i].K[1];
+				x->pos = ++C->nLlaves;
+				}
+			}
+		}
+	for(i=0;i<t && err == 0;i++)
+		{
+		x = ranura(I, nInd, sal, &K[i*2]);
+		if(x->pos == 0)
+			{
+			expandeLlave(&L[C->nLlaves], &K[i*2]);
+			x->K[0] = K[i*2];
+			x->K[1] = K[i*2+1];
+			x->pos = ++C->nLlaves;
+			}
+		}
+
+	tot = C->nLlaves;
+	err |= msync(m, tam, MS_SYNC) != 0;
+	munmap(m, tam);
+	err |= ftruncate(fd, (off_t)tamAlm(nInd, tot)) != 0;
+	err |= fsync(fd) != 0;
+	err |= close(fd) != 0;
+	if(err != 0 || rename(tmp, ruta) != 0)
+		{
+		unlink(tmp);
+		return(1);
+		}
+	sincDir(ruta);
+	return(0);
+	}
+
+/*
+ * Function: leeLlaves()
+ *
+ * Purpose: Reads 128-bit keys, one per line as 32 hex digits
+ *
+ * Parameters:
+ *   - FILE *f: Input
+ *   - size_t *t: Number of keys read (output)
+ *
+ * Returns:
+ *   - bloques: Keys, 2 blocks each (caller frees)
+ */
+static bloques leeLlaves(FILE *f, size_t *t)
+	{
+	size_t cap = 0x400;
+	bloques K = malloc(cap * 2 * sizeof(bloque));
+
+	*t = 0;
+	while(K != NULL && fscanf(f, "%16" SCNx64 "%16" SCNx64, &K[*t*2], &K[*t*2+1]) == 2)
+		{
+		if(++(*t) == cap)
+			{
+			cap <<= 1;
+			K = realloc(K, cap * 2 * sizeof(bloque));
+			}
+		}
+	if(K == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	return(K);
+	}
+
+/*
+ * Function: usoLlaves()
+ *
+ * Purpose: Prints the usage of the llaves subcommand
+ */
+static int usoLlaves()
+	{
+	fprintf(stderr,"Uso: cifrador llaves crear ALMACEN [LLAVES]\n");
+	fprintf(stderr,"     cifrador llaves agregar ALMACEN [LLAVES]\n");
+	fprintf(stderr,"     cifrador llaves info ALMACEN\n");
+	fprintf(stderr,"     cifrador llaves buscar ALMACEN [LLAVE]\n");
+	fprintf(stderr,"     LLAVES: una llave de 32 digitos hex por linea (stdin por omision)\n");
+	fprintf(stderr,"     LLAVE: archivo con una llave de 32 digitos hex (stdin por omision)\n");
+	return(1);
+	}
+
+/*
+ * Function: llaves()
+ *
+ * Purpose: Entry point of "cifrador llaves"
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "llaves")
+ *   - char *argv[]: Action, store path and its arguments
+ *
+ * Actions:
+ *   - crear:   New store with the given keys (replaces any old one)
+ *   - agregar: Copy-on-write update adding keys to an existing store
+ *   - info:    Size of the store, time to map it and to fault in every
+ *              key, against the time keyGen() needs for as many keys;
+ *              also checks every index slot
+ *   - buscar:  Looks a key up and checks it against expandeLlave(); the
+ *              key is read from a file or stdin, never from argv
+ *
+ * Returns:
+ *   - int: 0 on success, 1 on usage or I/O errors or a damaged index, 2
+ *          if buscar does not find the key or finds a different schedule
+ */
+int llaves(int argc, char *argv[])
+	{
+	almacen A;
+	almacen *ant = NULL;
+	bloques K;
+	bloque Kb[2];
+	size_t t;
+	uint64_t i;
+	uint64_t nExp;
+	uint64_t nOcup = 0;
+	volatile bloque x = 0;
+	bloque sem = 0x6b657973746f7265;
+	double t0;
+	double tMap;
+	double tTodo;
+	double tExp;
+	llaveExp E;
+	llaveExp *P;
+	FILE *f = stdin;
+	byte err;
+
+	if(argc < 3)
+		{
+		return(usoLlaves());
+		}
+
+	if(strcmp(argv[1], "crear") == 0 || strcmp(argv[1], "agregar") == 0)
+		{
+		if(argc > 3 && (f = fopen(argv[3], "r")) == NULL)
+			{
+			fprintf(stderr,"Error al abrir %s\n", argv[3]);
+			return(1);
+			}
+		K = leeLlaves(f, &t);
+		if(f != stdin)
+			{
+			fclose(f);
+			}
+		if(argv[1][0] == 'a')
+			{
+			if(almAbre(argv[2], &A) != 0)
+				{
+				fprintf(stderr,"Almacen invalido: %s\n", argv[2]);
+				free(K);
+				return(1);
+				}
+			ant = &A;
+			}
+		err = almEscribe(argv[2], ant, K, t);
+		if(ant != NULL)
+			{
+			almCierra(ant);
+			}
+		free(K);
+		if(err != 0)
+			{
+			fprintf(stderr,"Error al escribir %s\n", argv[2]);
+			return(1);
+			}
+		return(0);
+		}
+
+	t0 = metReloj();
+	if(almAbre(argv[2], &A) != 0)
+		{
+		fprintf(stderr,"Almacen invalido: %s\n", argv[2]);
+		return(1);
+		}
+	tMap = metReloj() - t0;
+
+	if(strcmp(argv[1], "info") == 0)
+		{
+		// Fault in every key through its index slot, as lookups would;
+		// a slot the lookup does not resolve to itself is damaged
+		t0 = metReloj();
+		err = 0;
+		for(i=0;i<A.C->nInd;i++)
+			{
+			if(A.I[i].pos != 0)
+				{
+				P = almBusca(&A, A.I[i].K);
+				err |= P == NULL || P != &A.L[A.I[i].pos - 1];
+				x ^= P != NULL ? P->RK[0] : 0;
+				nOcup++;
+				}
+			}
+		tTodo = metReloj() - t0;
+
+		// keyGen() cost for as many keys, extrapolated from a sample
+		nExp = A.C->nLlaves < 0x1000 ? A.C->nLlaves : 0x1000;
+		t0 = metReloj();
+		for(i=0;i<nExp;i++)
+			{
+			Kb[0] = aleat(&sem);
+			Kb[1] = aleat(&sem);
+			expandeLlave(&E, Kb);
+			x ^= E.RK[0];
+			}
+		tExp = nExp > 0 ? (metReloj() - t0) / (double)nExp * (double)A.C->nLlaves : 0;
+
+		printf("llaves:     %" PRIu64 "\n", A.C->nLlaves);
+		printf("ranuras:    %" PRIu64 " (ocupacion %.2f)\n", A.C->nInd, (double)A.C->nLlaves / (double)A.C->nInd);
+		printf("bytes:      %zu\n", A.t);
+		printf("proyeccion: %.3f ms\n", tMap * 1e3);
+		printf("busquedas:  %.3f ms (todas las llaves)\n", tTodo * 1e3);
+		printf("keyGen:     %.3f ms (estimado para todas las llaves)\n", tExp * 1e3);
+		err |= nOcup != A.C->nLlaves;
+		almCierra(&A);
+		if(err != 0)
+			{
+			fprintf(stderr,"Indice danado: %s\n", argv[2]);
+			return(1);
+			}
+		return(0);
+		}
+
+	if(strcmp(argv[1], "buscar") == 0)
+		{
+		if(leeLlave(argc > 3 ? argv[3] : "/dev/stdin", Kb) != 0)
+			{
+			almCierra(&A);
+			return(usoLlaves());
+			}
+		P = almBusca(&A, Kb);
+		expandeLlave(&E, Kb);
+		err = (P == NULL) ? 2 : (memcmp(P, &E, sizeof(llaveExp)) != 0) * 2;
+		printf("llave: %s\n", P == NULL ? "no encontrada" : (err ? "distinta" : "encontrada"));
+		almCierra(&A);
+		return(err);
+		}
+
+	almCierra(&A);
+	return(usoLlaves());
+	}
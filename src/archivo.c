@@ -0,0 +1,1205 @@
+/*
+ * ============================================================================
+ * File: archivo.c
+ * Purpose: File encryption over interchangeable I/O paths
+ *
+ * Every mode runs the same incremental COFB operation (COFBsig()) over a
+ * file, so the cost of each way of moving the bytes can be compared:
+ * - stdio: hex text read with fscanf() and written with fprintf(), the
+ *          path used by the interactive reader of cifrador
+ * - rw:    binary chunks with read() and write()
+ * - mmap:  input and output files mapped into memory
+ * - hilos: reader and writer threads around the encrypting thread
+ * - uring: reads and writes queued on an io_uring (Linux only), the next
+ *          read and the previous write overlap with the encryption
+ * - hex:   the stdio format in arcTrozoHex chunks: hex decoded through a
+ *          table, encrypted and encoded back while the chunk is still in
+ *          cache, one read() and one write() per chunk. The same decoder
+ *          and encoder (arcDeHex(), arcAHex()) serve "cifrador flujo -x"
+ * - splice: without encryption the input is moved with splice() (Linux
+ *          only) and never enters user memory; encrypted chunks go through
+ *          the salida writer, write() into a pipe sized to arcTrozo
+ *
+ * Binary modes store each 64-bit block in big-endian order. The stdio
+ * and hex modes read 16 hex digits per block (whitespace between digits
+ * is skipped) and write them without separators.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#define _GNU_SOURCE		//splice() y F_SETPIPE_SZ
+#include"archivo.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#define haySplice 1
+#endif
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define hayUring 1
+#endif
+#endif
+
+/*
+ * Mode labels used in reports, indexed by arcStdio..arcUring
+ */
+const char * nomArc[nArc] = {"stdio", "rw", "mmap", "hilos", "uring", "splice", "hex"};
+
+/*
+ * Function: leeTodo()
+ *
+ * Purpose: Reads until the buffer is full or the file ends
+ *
+ * Parameters:
+ *   - int fd: Descriptor to read from
+ *   - bytes p: Destination buffer
+ *   - size_t t: Bytes wanted
+ *
+ * Returns:
+ *   - size_t: Bytes read (less than t only at end of file or on error)
+ */
+size_t leeTodo(int fd, bytes p, size_t t)
+	{
+	size_t l = 0;
+	ssize_t x;
+
+	while(l < t)
+		{
+		x = read(fd, p + l, t - l);
+		if(x < 0 && errno == EINTR)
+			{
+			continue;
+			}
+		if(x <= 0)
+			{
+			break;
+			}
+		l += (size_t)x;
+		}
+	return(l);
+	}
+
+/*
+ * Function: escTodo()
+ *
+ * Purpose: Writes a whole buffer, retrying short writes
+ *
+ * Parameters:
+ *   - int fd: Descriptor to write to
+ *   - bytes p: Data
+ *   - size_t t: Bytes to write
+ *
+ * Returns:
+ *   - 0: Everything written
+ *   - 1: Write error
+ */
+byte escTodo(int fd, bytes p, size_t t)
+	{
+	ssize_t x;
+
+	while(t > 0)
+		{
+		x = write(fd, p, t);
+		if(x < 0 && errno == EINTR)
+			{
+			continue;
+			}
+		if(x <= 0)
+			{
+			return(1);
+			}
+		p += x;
+		t -= (size_t)x;
+		}
+	return(0);
+	}
+
+/*
+ * Function: leeTodoEn()
+ *
+ * Purpose: Reads a range at a given offset, retrying short reads
+ *
+ * Parameters:
+ *   - int fd: Descriptor to read from (its offset is not used)
+ *   - bytes p: Destination buffer
+ *   - size_t t: Bytes wanted
+ *   - uint64_t off: File offset
+ *
+ * Returns:
+ *   - 0: t bytes read
+ *   - 1: Read error or end of file
+ */
+byte leeTodoEn(int fd, bytes p, size_t t, uint64_t off)
+	{
+	ssize_t x;
+
+	while(t > 0)
+		{
+		x = pread(fd, p, t, (off_t)off);
+		if(x < 0 && errno == EINTR)
+			{
+			continue;
+			}
+		if(x <= 0)
+			{
+			return(1);
+			}
+		p += x;
+		t -= (size_t)x;
+		off += (uint64_t)x;
+		}
+	return(0);
+	}
+
+/*
+ * Function: escTodoEn()
+ *
+ * Purpose: Writes a range at a given offset, retrying short writes
+ *
+ * Parameters:
+ *   - int fd: Descriptor to write to (its offset is not used)
+ *   - bytes p: Data
+ *   - size_t t: Bytes to write
+ *   - uint64_t off: File offset
+ *
+ * Returns:
+ *   - 0: Everything written
+ *   - 1: Write error
+ */
+byte escTodoEn(int fd, bytes p, size_t t, uint64_t off)
+	{
+	ssize_t x;
+
+	while(t > 0)
+		{
+		x = pwrite(fd, p, t, (off_t)off);
+		if(x < 0 && errno == EINTR)
+			{
+			continue;
+			}
+		if(x <= 0)
+			{
+			return(1);
+			}
+		p += x;
+		t -= (size_t)x;
+		off += (uint64_t)x;
+		}
+	return(0);
+	}
+
+/*
+ * Function: procesa()
+ *
+ * Purpose: Runs one binary chunk through the operation
+ *
+ * Parameters:
+ *   - cofbEdo *E: Operation state, or NULL to only move the bytes
+ *   - bytes e: Input bytes
+ *   - bytes s: Output bytes (may alias e)
+ *   - bloques B: Scratch blocks (t / 8 blocks)
+ *   - size_t t: Chunk size in bytes (multiple of 8)
+ *
+ * Returns: void
+ */
+static void procesa(cofbEdo *E, bytes e, bytes s, bloques B, size_t t)
+	{
+	cargaBEs(e, B, t / n_8);
+	if(E != NULL)
+		{
+		COFBsig(E, B, t / n_8, B);
+		}
+	guardaBEs(B, s, t / n_8);
+	return;
+	}
+
+/*
+ * Function: cifraStdio()
+ *
+ * Purpose: stdio mode, one fscanf()/fprintf() per block
+ */
+static byte cifraStdio(int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	FILE *fe = fdopen(dup(fdE), "r");
+	FILE *fs = fdopen(dup(fdS), "w");
+	uint64_t i;
+	bloque B;
+	byte err = 0;
+
+	if(fe == NULL || fs == NULL)
+		{
+		err = 1;
+		}
+	for(i=0;i<tam/n_8 && err == 0;i++)
+		{
+		if(fscanf(fe, "%16" SCNx64, &B) != 1)
+			{
+			err = 1;
+			break;
+			}
+		if(E != NULL)
+			{
+			COFBsig(E, &B, 1, &B);
+			}
+		fprintf(fs, "%016" PRIx64, B);
+		}
+	if(fe != NULL)
+		{
+		fclose(fe);
+		}
+	if(fs != NULL && fclose(fs) != 0)
+		{
+		err = 1;
+		}
+	return(err);
+	}
+
+/*
+ * Function: cifraRW()
+ *
+ * Purpose: rw mode, chunks read, processed in place and written back
+ */
+static byte cifraRW(int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	bytes b = malloc(arcTrozo);
+	bloques B = malloc(arcTrozo);
+	size_t t;
+	byte err = 0;
+
+	if(b == NULL || B == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	while(tam > 0 && err == 0)
+		{
+		t = tam < arcTrozo ? (size_t)tam : arcTrozo;
+		if(leeTodo(fdE, b, t) != t)
+			{
+			err = 1;
+			break;
+			}
+		procesa(E, b, b, B, t);
+		err = escTodo(fdS, b, t);
+		tam -= t;
+		}
+	free(b);
+	free(B);
+	return(err);
+	}
+
+/*
+ * Function: cifraMmap()
+ *
+ * Purpose: mmap mode, output sized with ftruncate() and written through
+ *          its mapping
+ */
+static byte cifraMmap(int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	bytes e;
+	bytes s;
+	bloques B;
+	uint64_t i;
+	size_t t;
+
+	if(tam == 0)
+		{
+		return(0);
+		}
+	if(ftruncate(fdS, (off_t)tam) != 0)
+		{
+		return(1);
+		}
+	e = mmap(NULL, tam, PROT_READ, MAP_PRIVATE, fdE, 0);
+	s = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_SHARED, fdS, 0);
+	B = malloc(arcTrozo);
+	if(e == MAP_FAILED || s == MAP_FAILED || B == NULL)
+		{
+		if(e != MAP_FAILED)
+			{
+			munmap(e, tam);
+			}
+		if(s != MAP_FAILED)
+			{
+			munmap(s, tam);
+			}
+		free(B);
+		return(1);
+		}
+	madvise(e, tam, MADV_SEQUENTIAL);
+	madvise(s, tam, MADV_SEQUENTIAL);
+
+	for(i=0;i<tam;i+=t)
+		{
+		t = tam - i < arcTrozo ? (size_t)(tam - i) : arcTrozo;
+		procesa(E, e + i, s + i, B, t);
+		}
+
+	free(B);
+	munmap(e, tam);
+	return(munmap(s, tam) != 0);
+	}
+
+/*
+ * Pipeline of the hilos mode
+ *
+ * Chunk i lives in slot i % arcRan and moves through the states
+ * libre -> leido (reader) -> cifrado (main thread) -> libre (writer).
+ */
+#define ranLibre	0x00
+#define ranLeido	0x01
+#define ranCifrado	0x02
+
+typedef struct TubS{
+	pthread_mutex_t	mtx;
+	pthread_cond_t	cv;
+	bytes		b[arcRan];	//trozo de cada ranura
+	byte		edo[arcRan];	//estado de cada ranura
+	byte		err;		//1 si alguna etapa fallo
+	int		fdE;
+	int		fdS;
+	uint64_t	tam;
+	} tubo;
+
+/*
+ * Function: tuboEspera()
+ *
+ * Purpose: Waits until a slot reaches a state or the pipeline fails
+ *
+ * Returns:
+ *   - 0: Slot ready
+ *   - 1: Another stage failed
+ */
+static byte tuboEspera(tubo *P, size_t k, byte edo)
+	{
+	byte err;
+
+	pthread_mutex_lock(&P->mtx);
+	while(P->edo[k] != edo && P->err == 0)
+		{
+		pthread_cond_wait(&P->cv, &P->mtx);
+		}
+	err = P->err;
+	pthread_mutex_unlock(&P->mtx);
+	return(err);
+	}
+
+/*
+ * Function: tuboPasa()
+ *
+ * Purpose: Moves a slot to its next state, or flags a failure
+ */
+static void tuboPasa(tubo *P, size_t k, byte edo, byte err)
+	{
+	pthread_mutex_lock(&P->mtx);
+	P->edo[k] = edo;
+	P->err |= err;
+	pthread_cond_broadcast(&P->cv);
+	pthread_mutex_unlock(&P->mtx);
+	return;
+	}
+
+/*
+ * Function: tuboLector()
+ *
+ * Purpose: Reader stage of the hilos mode
+ */
+static void * tuboLector(void *x)
+	{
+	tubo *P = x;
+	uint64_t i;
+	size_t k = 0;
+	size_t t;
+
+	for(i=0;i<P->tam;i+=t)
+		{
+		t = P->tam - i < arcTrozo ? (size_t)(P->tam - i) : arcTrozo;
+		if(tuboEspera(P, k, ranLibre) != 0)
+			{
+			break;
+			}
+		tuboPasa(P, k, ranLeido, leeTodo(P->fdE, P->b[k], t) != t);
+		k = (k + 1) % arcRan;
+		}
+	return(NULL);
+	}
+
+/*
+ * Function: tuboEscritor()
+ *
+ * Purpose: Writer stage of the hilos mode
+ */
+static void * tuboEscritor(void *x)
+	{
+	tubo *P = x;
+	uint64_t i;
+	size_t k = 0;
+	size_t t;
+
+	for(i=0;i<P->tam;i+=t)
+		{
+		t = P->tam - i < arcTrozo ? (size_t)(P->tam - i) : arcTrozo;
+		if(tuboEspera(P, k, ranCifrado) != 0)
+			{
+			break;
+			}
+		tuboPasa(P, k, ranLibre, escTodo(P->fdS, P->b[k], t));
+		k = (k + 1) % arcRan;
+		}
+	return(NULL);
+	}
+
+/*
+ * Function: cifraHilos()
+ *
+ * Purpose: hilos mode, reader -> encryption -> writer pipeline
+ *
+ * Details: The operation itself is sequential, so the calling thread
+ *          encrypts while the reader fills up to arcRan - 1 chunks ahead
+ *          and the writer drains the finished ones
+ */
+static byte cifraHilos(int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	tubo P;
+	pthread_t hl;
+	pthread_t he;
+	bloques B = malloc(arcTrozo);
+	uint64_t i;
+	size_t k;
+	size_t t;
+	byte falta = (B == NULL);
+
+	memset(&P, 0, sizeof(tubo));
+	P.fdE = fdE;
+	P.fdS = fdS;
+	P.tam = tam;
+	for(k=0;k<arcRan;k++)
+		{
+		P.b[k] = malloc(arcTrozo);
+		falta |= (P.b[k] == NULL);
+		}
+	if(falta != 0)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	pthread_mutex_init(&P.mtx, NULL);
+	pthread_cond_init(&P.cv, NULL);
+	pthread_create(&hl, NULL, tuboLector, &P);
+	pthread_create(&he, NULL, tuboEscritor, &P);
+
+	for(i=0,k=0;i<tam;i+=t)
+		{
+		t = tam - i < arcTrozo ? (size_t)(tam - i) : arcTrozo;
+		if(tuboEspera(&P, k, ranLeido) != 0)
+			{
+			break;
+			}
+		procesa(E, P.b[k], P.b[k], B, t);
+		tuboPasa(&P, k, ranCifrado, 0);
+		k = (k + 1) % arcRan;
+		}
+
+	pthread_join(hl, NULL);
+	pthread_join(he, NULL);
+	pthread_mutex_destroy(&P.mtx);
+	pthread_cond_destroy(&P.cv);
+	for(k=0;k<arcRan;k++)
+		{
+		free(P.b[k]);
+		}
+	free(B);
+	return(P.err);
+	}
+
+#ifdef hayUring
+/*
+ * Submission and completion rings shared with the kernel
+ */
+typedef struct AniS{
+	int			 fd;
+	unsigned		*sqCola;
+	unsigned		*sqMsk;
+	unsigned		*sqArr;
+	unsigned		*cqCab;
+	unsigned		*cqCola;
+	unsigned		*cqMsk;
+	struct io_uring_sqe	*sqe;
+	struct io_uring_cqe	*cqe;
+	void			*mSq;
+	void			*mCq;
+	size_t			 tSq;
+	size_t			 tCq;
+	size_t			 tSqe;
+	} anillo;
+
+/*
+ * Function: urAbre()
+ *
+ * Purpose: Creates an io_uring and maps its rings
+ *
+ * Returns:
+ *   - 0: Ring ready
+ *   - 1: io_uring unavailable (old kernel, seccomp filter, ...)
+ */
+static byte urAbre(anillo *A, unsigned ent)
+	{
+	struct io_uring_params p;
+
+	memset(&p, 0, sizeof(p));
+	A->fd = (int)syscall(__NR_io_uring_setup, ent, &p);
+	if(A->fd < 0)
+		{
+		return(1);
+		}
+	A->tSq	= p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	A->tCq	= p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	A->tSqe	= p.sq_entries * sizeof(struct io_uring_sqe);
+	if(p.features & IORING_FEAT_SINGLE_MMAP)
+		{
+		A->tSq = A->tCq = A->tSq > A->tCq ? A->tSq : A->tCq;
+		}
+	A->mSq = mmap(NULL, A->tSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, A->fd, IORING_OFF_SQ_RING);
+	A->mCq = (p.features & IORING_FEAT_SINGLE_MMAP) ? A->mSq :
+		mmap(NULL, A->tCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, A->fd, IORING_OFF_CQ_RING);
+	A->sqe = mmap(NULL, A->tSqe, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, A->fd, IORING_OFF_SQES);
+	if(A->mSq == MAP_FAILED || A->mCq == MAP_FAILED || A->sqe == MAP_FAILED)
+		{
+		// Release whichever rings did map
+		if(A->sqe != MAP_FAILED)
+			{
+			munmap(A->sqe, A->tSqe);
+			}
+		if(A->mCq != MAP_FAILED && A->mCq != A->mSq)
+			{
+			munmap(A->mCq, A->tCq);
+			}
+		if(A->mSq != MAP_FAILED)
+			{
+			munmap(A->mSq, A->tSq);
+			}
+		close(A->fd);
+		return(1);
+		}
+	A->sqCola	= (unsigned *)((char *)A->mSq + p.sq_off.tail);
+	A->sqMsk	= (unsigned *)((char *)A->mSq + p.sq_off.ring_mask);
+	A->sqArr	= (unsigned *)((char *)A->mSq + p.sq_off.array);
+	A->cqCab	= (unsigned *)((char *)A->mCq + p.cq_off.head);
+	A->cqCola	= (unsigned *)((char *)A->mCq + p.cq_off.tail);
+	A->cqMsk	= (unsigned *)((char *)A->mCq + p.cq_off.ring_mask);
+	A->cqe		= (struct io_uring_cqe *)((char *)A->mCq + p.cq_off.cqes);
+	return(0);
+	}
+
+/*
+ * Function: urCierra()
+ *
+ * Purpose: Unmaps the rings and closes the io_uring
+ */
+static void urCierra(anillo *A)
+	{
+	munmap(A->sqe, A->tSqe);
+	if(A->mCq != A->mSq)
+		{
+		munmap(A->mCq, A->tCq);
+		}
+	munmap(A->mSq, A->tSq);
+	close(A->fd);
+	return;
+	}
+
+/*
+ * Function: urEnvia()
+ *
+ * Purpose: Queues one read or write and submits it to the kernel
+ *
+ * Parameters:
+ *   - anillo *A: Ring
+ *   - byte op: IORING_OP_READ or IORING_OP_WRITE
+ *   - int fd: File descriptor
+ *   - bytes p: Buffer
+ *   - size_t t: Bytes to transfer
+ *   - uint64_t off: File offset
+ *   - uint64_t dato: Tag returned with the completion
+ *
+ * Returns:
+ *   - 0: Submitted
+ *   - 1: io_uring_enter() failed
+ */
+static byte urEnvia(anillo *A, byte op, int fd, bytes p, size_t t, uint64_t off, uint64_t dato)
+	{
+	unsigned cola = *A->sqCola;
+	unsigned i = cola & *A->sqMsk;
+	struct io_uring_sqe *s = &A->sqe[i];
+
+	memset(s, 0, sizeof(struct io_uring_sqe));
+	s->opcode	= op;
+	s->fd		= fd;
+	s->addr		= (uint64_t)(uintptr_t)p;
+	s->len		= (unsigned)t;
+	s->off		= off;
+	s->user_data	= dato;
+	A->sqArr[i]	= i;
+	__atomic_store_n(A->sqCola, cola + 1, __ATOMIC_RELEASE);
+	while(syscall(__NR_io_uring_enter, A->fd, 1, 0, 0, NULL, 0) < 0)
+		{
+		if(errno != EINTR)
+			{
+			return(1);
+			}
+		}
+	return(0);
+	}
+
+/*
+ * Function: urCosecha()
+ *
+ * Purpose: Waits for the next completion
+ *
+ * Parameters:
+ *   - anillo *A: Ring
+ *   - int *res: Result of the operation (bytes or -errno)
+ *   - uint64_t *dato: Tag given to urEnvia()
+ *
+ * Returns:
+ *   - 0: Completion consumed
+ *   - 1: io_uring_enter() failed
+ */
+static byte urCosecha(anillo *A, int *res, uint64_t *dato)
+	{
+	unsigned cab = *A->cqCab;
+	struct io_uring_cqe *c;
+
+	while(cab == __atomic_load_n(A->cqCola, __ATOMIC_ACQUIRE))
+		{
+		if(syscall(__NR_io_uring_enter, A->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+			{
+			return(1);
+			}
+		}
+	c	= &A->cqe[cab & *A->cqMsk];
+	*res	= c->res;
+	*dato	= c->user_data;
+	__atomic_store_n(A->cqCab, cab + 1, __ATOMIC_RELEASE);
+	return(0);
+	}
+
+/*
+ * Function: urEspera()
+ *
+ * Purpose: Consumes completions until a slot has no operation of the
+ *          given kind in flight
+ *
+ * Parameters:
+ *   - anillo *A: Ring
+ *   - byte *pend: In-flight bits per slot (1 read, 2 write)
+ *   - size_t *t: Expected bytes per slot
+ *   - size_t k: Slot to wait for
+ *   - byte bit: Kind to wait for
+ *
+ * Returns:
+ *   - 0: Done
+ *   - 1: Failed or short transfer
+ */
+static byte urEspera(anillo *A, byte *pend, size_t *t, size_t k, byte bit)
+	{
+	int res;
+	uint64_t dato;
+	size_t j;
+	byte err = 0;
+
+	while(pend[k] & bit)
+		{
+		if(urCosecha(A, &res, &dato) != 0)
+			{
+			return(1);
+			}
+		j = (size_t)(dato >> 1);
+		pend[j] &= (byte)~(1 << (dato & 1));
+		err |= (res < 0 || (size_t)res != t[j]);
+		}
+	return(err);
+	}
+
+/*
+ * Function: cifraUring()
+ *
+ * Purpose: uring mode, read ahead and write behind on an io_uring
+ *
+ * Details: With three slots, chunk i is encrypted while chunk i + 1 is
+ *          being read and chunk i - 1 written; a slot is reused only
+ *          after the write of its previous chunk completed
+ */
+static byte cifraUring(int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	anillo A;
+	bytes b[3];
+	size_t t[3];
+	byte pend[3] = {0, 0, 0};
+	bloques B;
+	uint64_t nTr = (tam + arcTrozo - 1) / arcTrozo;
+	uint64_t i;
+	size_t k;
+	size_t k1;
+	byte err = 0;
+	byte falta;
+
+	if(urAbre(&A, arcRan) != 0)
+		{
+		return(arcNoDisp);
+		}
+	B = malloc(arcTrozo);
+	falta = (B == NULL);
+	for(k=0;k<3;k++)
+		{
+		b[k] = malloc(arcTrozo);
+		falta |= (b[k] == NULL);
+		}
+	if(falta != 0)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+
+	if(nTr > 0)
+		{
+		t[0] = tam < arcTrozo ? (size_t)tam : arcTrozo;
+		pend[0] = 1;
+		err = urEnvia(&A, IORING_OP_READ, fdE, b[0], t[0], 0, 0);
+		}
+	for(i=0;i<nTr && err == 0;i++)
+		{
+		k = i % 3;
+		if((err = urEspera(&A, pend, t, k, 1)) != 0)
+			{
+			break;
+			}
+		if(i + 1 < nTr)
+			{
+			k1 = (i + 1) % 3;
+			if((err = urEspera(&A, pend, t, k1, 2)) != 0)
+				{
+				break;
+				}
+			t[k1] = tam - (i + 1) * arcTrozo < arcTrozo ? (size_t)(tam - (i + 1) * arcTrozo) : arcTrozo;
+			pend[k1] |= 1;
+			err = urEnvia(&A, IORING_OP_READ, fdE, b[k1], t[k1], (i + 1) * arcTrozo, k1 << 1);
+			}
+		procesa(E, b[k], b[k], B, t[k]);
+		pend[k] |= 2;
+		err |= urEnvia(&A, IORING_OP_WRITE, fdS, b[k], t[k], i * arcTrozo, (k << 1) | 1);
+		}
+	for(k=0;k<3;k++)
+		{
+		err |= urEspera(&A, pend, t, k, 3);
+		free(b[k]);
+		}
+	free(B);
+	urCierra(&A);
+	return(err);
+	}
+#endif
+
+/*
+ * Function: salAbre()
+ *
+ * Purpose: Prepares a writer for an output descriptor
+ *
+ * Parameters:
+ *   - salida *S: Writer (output)
+ *   - int fd: Output descriptor
+ *
+ * Returns:
+ *   - 0: Ready
+ *   - 1: Out of memory
+ *
+ * Details: When fd is a pipe its capacity is raised to arcTrozo where
+ *          allowed and emissions are limited to it, so each emission is
+ *          one write() the reader can take in one piece. Gifting fresh
+ *          pages with vmsplice() instead measured slower (mapping,
+ *          prefaulting and unmapping 1 MiB per emission costs more than
+ *          the copy it saves), so pipes use write() as well.
+ */
+byte salAbre(salida *S, int fd)
+	{
+#ifdef haySplice
+	struct stat st;
+	int cap;
+#endif
+
+	memset(S, 0, sizeof(salida));
+	S->fd	= fd;
+	S->max	= arcTrozo;
+#ifdef haySplice
+	if(fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode))
+		{
+		fcntl(fd, F_SETPIPE_SZ, arcTrozo);
+		cap = fcntl(fd, F_GETPIPE_SZ);
+		if(cap > 0)
+			{
+			S->max	= (size_t)cap;
+			}
+		}
+#endif
+	S->b = malloc(S->max);
+	return(S->b == NULL);
+	}
+
+/*
+ * Function: salPide()
+ *
+ * Purpose: Space for the next emission
+ *
+ * Parameters:
+ *   - salida *S: Writer
+ *   - size_t t: Bytes to be produced (at most S->max)
+ *
+ * Returns:
+ *   - bytes: t contiguous bytes to fill before calling salEmite()
+ */
+bytes salPide(salida *S, size_t t)
+	{
+	(void)t;
+	return(S->b);
+	}
+
+/*
+ * Function: salEmite()
+ *
+ * Purpose: Hands the bytes filled after salPide() to the output
+ *
+ * Parameters:
+ *   - salida *S: Writer
+ *   - size_t t: Bytes filled
+ *
+ * Returns:
+ *   - 0: Written
+ *   - 1: Write error (including a closed reader)
+ */
+byte salEmite(salida *S, size_t t)
+	{
+	return(escTodo(S->fd, S->b, t));
+	}
+
+/*
+ * Function: salCierra()
+ *
+ * Purpose: Releases the buffer of a writer
+ */
+void salCierra(salida *S)
+	{
+	free(S->b);
+	S->b = NULL;
+	return;
+	}
+
+#ifdef haySplice
+/*
+ * Function: copiaSplice()
+ *
+ * Purpose: Copies a file with splice(), through a private pipe unless
+ *          the output already is one
+ */
+static byte copiaSplice(int fdE, int fdS, uint64_t tam)
+	{
+	struct stat st;
+	int p[2] = {-1, -1};
+	int fdP = fdS;
+	uint64_t movido = 0;
+	ssize_t l;
+	ssize_t k;
+	byte err = 0;
+
+	if(fstat(fdS, &st) != 0)
+		{
+		return(1);
+		}
+	if(!S_ISFIFO(st.st_mode))
+		{
+		if(pipe(p) != 0)
+			{
+			return(1);
+			}
+		fdP = p[1];
+		}
+	while(movido < tam && err == 0)
+		{
+		l = splice(fdE, NULL, fdP, NULL, tam - movido < arcTrozo ? (size_t)(tam - movido) : arcTrozo, SPLICE_F_MOVE);
+		if(l < 0 && errno == EINTR)
+			{
+			continue;
+			}
+		if(l < 0 && errno == EINVAL && movido == 0)
+			{
+			// Input without splice support: plain copy
+			err = cifraRW(fdE, fdS, tam, NULL);
+			break;
+			}
+		if(l <= 0)
+			{
+			err = 1;
+			break;
+			}
+		movido += (uint64_t)l;
+		while(l > 0 && fdP != fdS)
+			{
+			k = splice(p[0], NULL, fdS, NULL, (size_t)l, SPLICE_F_MOVE);
+			if(k < 0 && errno == EINTR)
+				{
+				continue;
+				}
+			if(k <= 0)
+				{
+				err = 1;
+				break;
+				}
+			l -= k;
+			}
+		}
+	if(p[0] >= 0)
+		{
+		close(p[0]);
+		close(p[1]);
+		}
+	return(err);
+	}
+#endif
+
+/*
+ * Function: cifraSplice()
+ *
+ * Purpose: splice mode, chunks encrypted in place in the writer's buffer
+ */
+static byte cifraSplice(int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	salida S;
+	bloques B;
+	bytes x;
+	size_t t;
+	byte err = 0;
+
+#ifdef haySplice
+	if(E == NULL)
+		{
+		return(copiaSplice(fdE, fdS, tam));
+		}
+#endif
+	if(salAbre(&S, fdS) != 0 || (B = malloc(S.max)) == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	while(tam > 0 && err == 0)
+		{
+		t = tam < S.max ? (size_t)tam : S.max;
+		x = salPide(&S, t);
+		if(leeTodo(fdE, x, t) != t)
+			{
+			err = 1;
+			break;
+			}
+		procesa(E, x, x, B, t);
+		err = salEmite(&S, t);
+		tam -= t;
+		}
+	free(B);
+	salCierra(&S);
+	return(err);
+	}
+
+/*
+ * Hex digit values plus one, so 0 marks a character that is neither a
+ * digit nor whitespace
+ */
+#define hexEsp		0x20	//espacio entre digitos, se ignora
+
+static const byte valHex[0x100] = {
+	['0'] = 0x01, ['1'] = 0x02, ['2'] = 0x03, ['3'] = 0x04, ['4'] = 0x05,
+	['5'] = 0x06, ['6'] = 0x07, ['7'] = 0x08, ['8'] = 0x09, ['9'] = 0x0a,
+	['a'] = 0x0b, ['b'] = 0x0c, ['c'] = 0x0d, ['d'] = 0x0e, ['e'] = 0x0f, ['f'] = 0x10,
+	['A'] = 0x0b, ['B'] = 0x0c, ['C'] = 0x0d, ['D'] = 0x0e, ['E'] = 0x0f, ['F'] = 0x10,
+	[' '] = hexEsp, ['\t'] = hexEsp, ['\n'] = hexEsp, ['\r'] = hexEsp,
+	};
+
+static const char digHex[0x10] = "0123456789abcdef";
+
+/*
+ * Function: arcDeHex()
+ *
+ * Purpose: Decodes a chunk of hex text into bytes
+ *
+ * Parameters:
+ *   - const char *e: Hex digits, whitespace anywhere is skipped
+ *   - size_t l: Characters in e
+ *   - bytes p: Decoded bytes (output, room for (l + 1) / 2)
+ *   - size_t *t: Bytes written to p (output)
+ *   - int *med: High nibble of a byte split across chunks, -1 if none;
+ *               start at -1 and pass the same variable for every chunk
+ *
+ * Returns:
+ *   - 0: Chunk decoded
+ *   - 1: A character is neither a hex digit nor whitespace
+ */
+byte arcDeHex(const char *e, size_t l, bytes p, size_t *t, int *med)
+	{
+	size_t i;
+	byte v;
+
+	*t = 0;
+	for(i=0;i<l;i++)
+		{
+		v = valHex[(byte)e[i]];
+		if(v == hexEsp)
+			{
+			continue;
+			}
+		if(v == 0)
+			{
+			return(1);
+			}
+		if(*med < 0)
+			{
+			*med = v - 1;
+			continue;
+			}
+		p[(*t)++] = (byte)((*med << 4) | (v - 1));
+		*med = -1;
+		}
+	return(0);
+	}
+
+/*
+ * Function: arcAHex()
+ *
+ * Purpose: Encodes bytes as two lowercase hex digits each
+ *
+ * Parameters:
+ *   - const byte *p: Bytes to encode
+ *   - char *s: Digits (output, 2 * t characters, not terminated)
+ *   - size_t t: Bytes in p
+ */
+void arcAHex(const byte *p, char *s, size_t t)
+	{
+	size_t i;
+
+	for(i=0;i<t;i++)
+		{
+		s[i << 1]	= digHex[p[i] >> 4];
+		s[(i << 1) + 1]	= digHex[p[i] & 0x0f];
+		}
+	return;
+	}
+
+/*
+ * Function: cifraHex()
+ *
+ * Purpose: hex mode, decode, COFB and encode fused per chunk
+ *
+ * Details: Digits and bytes carry over chunk boundaries, so blocks may
+ *          be split across reads. Each chunk of hex becomes at most
+ *          arcTrozoHex / 16 blocks and as many output digits, so the
+ *          buffers stay within the data cache.
+ */
+static byte cifraHex(int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	char *e = malloc(arcTrozoHex);
+	char *s = malloc(arcTrozoHex + 4 * n_8);
+	bytes p = malloc((arcTrozoHex >> 1) + 2 * n_8);
+	bloques B = malloc((arcTrozoHex >> 1) + 2 * n_8);
+	size_t l;
+	size_t t;
+	size_t k;
+	size_t q = 0;
+	int med = -1;
+	byte err = 0;
+
+	if(e == NULL || s == NULL || p == NULL || B == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	while(tam > 0 && err == 0)
+		{
+		l = leeTodo(fdE, (bytes)e, arcTrozoHex);
+		if(l == 0 || arcDeHex(e, l, p + q, &t, &med) != 0)
+			{
+			err = 1;
+			break;
+			}
+		q += t;
+		k = q / n_8 < tam / n_8 ? q / n_8 : (size_t)(tam / n_8);
+		cargaBEs(p, B, k);
+		if(E != NULL)
+			{
+			COFBsig(E, B, k, B);
+			}
+		guardaBEs(B, p, k);
+		arcAHex(p, s, k * n_8);
+		err |= escTodo(fdS, (bytes)s, k << 4);
+		tam -= k * n_8;
+		q -= k * n_8;
+		memmove(p, p + k * n_8, q);
+		}
+	free(e);
+	free(s);
+	free(p);
+	free(B);
+	return(err);
+	}
+
+/*
+ * Function: arcCifra()
+ *
+ * Purpose: Runs an incremental COFB operation over a whole file
+ *
+ * Parameters:
+ *   - byte modo: I/O path (arcStdio..arcHex)
+ *   - int fdE: Input descriptor, positioned at the start
+ *   - int fdS: Output descriptor, empty and positioned at the start
+ *   - uint64_t tam: Payload bytes (multiple of 8)
+ *   - cofbEdo *E: State from COFBini(), or NULL to copy the blocks
+ *                 without encrypting (measures the I/O path alone)
+ *
+ * Returns:
+ *   - arcOk: tam bytes processed; the caller completes E with COFBfin()
+ *   - arcError: Read, write or mapping failure
+ *   - arcNoDisp: The mode is not supported on this system
+ *
+ * Details: tam counts binary payload bytes; the stdio and hex modes
+ *          read and write twice as many hex characters
+ */
+byte arcCifra(byte modo, int fdE, int fdS, uint64_t tam, cofbEdo *E)
+	{
+	if(tam % n_8 != 0)
+		{
+		return(arcError);
+		}
+	switch(modo)
+		{
+		case arcStdio:
+			return(cifraStdio(fdE, fdS, tam, E));
+		case arcRW:
+			return(cifraRW(fdE, fdS, tam, E));
+		case arcMmap:
+			return(cifraMmap(fdE, fdS, tam, E));
+		case arcHilos:
+			return(cifraHilos(fdE, fdS, tam, E));
+#ifdef hayUring
+		case arcUring:
+			return(cifraUring(fdE, fdS, tam, E));
+#endif
+		case arcSplice:
+			return(cifraSplice(fdE, fdS, tam, E));
+		case arcHex:
+			return(cifraHex(fdE, fdS, tam, E));
+		}
+	return(arcNoDisp);
+	}
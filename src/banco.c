@@ -0,0 +1,2558 @@
+/*
+ * ============================================================================
+ * File: banco.c
+ * Purpose: Benchmark modes of the cifrador command line tool
+ *
+ * Invoked as "cifrador bench MODE [options]". Available modes:
+ * - replay: Reproduces the operation mix and arrival timing of a trace
+ *           captured with "cifrador -t"
+ * - rend:   Throughput per (engine, op, size) over repeated trials, with
+ *           a statistical comparison against a stored baseline
+ * - frio:   Per-operation latency with evicted caches and rotating keys
+ * - lat:    Single-message latency per Midori engine (ref, ssse3) and
+ *           per-block cost of the batch kernels (esc, sse2, avx2)
+ * - io:     File encryption throughput and CPU cost per I/O path, with
+ *           a warm or dropped page cache
+ * - soak:   Hours of mixed batch and streaming operations, sampling
+ *           throughput, latency, RSS and heap use to flag drift
+ * - energia: Joules per GB and per message of every engine and thread
+ *           count from the RAPL counters, where they are readable
+ *
+ * All payloads and keys are synthesized with the seeded aleat() generator,
+ * so runs are reproducible and traces never need to contain real data.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"banco.h"
+#include <unistd.h>
+#include <getopt.h>
+#include <math.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <malloc.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#endif
+
+#define semBanco 0x436f46422d4d3634	//semilla de las cargas sinteticas
+#define lineaCache	0x40		//bytes por linea de cache
+#define latLote		0x10		//llamadas encadenadas por muestra de bench lat
+#define soakMu		0x1000		//muestras de latencia por intervalo de bench soak
+#define soakVent	0x03		//intervalos minimos de cada ventana de bench soak
+#define eneHilos	0x100		//hilos maximos de bench energia
+
+// mallinfo2() appeared in glibc 2.33
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define soakMallinfo
+#endif
+
+/*
+ * Work of one bench energia thread
+ */
+typedef struct EneS{
+	byte	 lote;		//0: COFBbuf() con nucMot, 1: midoriLote() con loteMot
+	uint64_t m;		//bloques por mensaje
+	double	 fin;		//instante de parada (metReloj)
+	uint64_t ops;		//mensajes procesados (salida)
+	} eneTrab;
+
+/*
+ * Operation labels used in reports, indexed by opCif/opDes
+ */
+static const char * nomOp[nOps] = {"enc", "dec"};
+
+/*
+ * Function: cmpDoble()
+ *
+ * Purpose: qsort() comparator for ascending doubles
+ */
+static int cmpDoble(const void *a, const void *b)
+	{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return((x > y) - (x < y));
+	}
+
+/*
+ * Function: cmpBloque()
+ *
+ * Purpose: qsort() comparator for ascending 64-bit blocks
+ */
+static int cmpBloque(const void *a, const void *b)
+	{
+	bloque x = *(const bloque *)a;
+	bloque y = *(const bloque *)b;
+	return((x > y) - (x < y));
+	}
+
+/*
+ * Function: cmpLlegada()
+ *
+ * Purpose: qsort() comparator ordering trace records by arrival time
+ */
+static int cmpLlegada(const void *a, const void *b)
+	{
+	uint64_t x = ((const registro *)a)->t;
+	uint64_t y = ((const registro *)b)->t;
+	return((x > y) - (x < y));
+	}
+
+/*
+ * Function: percentil()
+ *
+ * Purpose: Nearest-rank percentile of an ascending sorted sample
+ *
+ * Parameters:
+ *   - double *v: Sorted sample
+ *   - size_t t: Sample size
+ *   - double p: Percentile in [0, 1]
+ *
+ * Returns:
+ *   - double: Sample value at percentile p (0 for an empty sample)
+ */
+double percentil(double *v, size_t t, double p)
+	{
+	if(t == 0)
+		{
+		return(0);
+		}
+	return(v[(size_t)(p * (double)(t-1) + 0.5)]);
+	}
+
+/*
+ * Function: esperaHasta()
+ *
+ * Purpose: Sleeps until an absolute monotonic time
+ *
+ * Parameters:
+ *   - double obj: Target time in seconds, as returned by metReloj()
+ */
+static void esperaHasta(double obj)
+	{
+	struct timespec ts;
+
+	ts.tv_sec	= (time_t)obj;
+	ts.tv_nsec	= (long)((obj - (double)ts.tv_sec) * 1e9);
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0);
+	return;
+	}
+
+/*
+ * Function: usoBanco()
+ *
+ * Purpose: Prints the usage of the bench subcommand
+ */
+static int usoBanco()
+	{
+	fprintf(stderr,"Uso: cifrador bench replay [-v factor] [-n] TRAZA\n");
+	fprintf(stderr,"     cifrador bench rend [opciones] (ver cifrador bench rend -h)\n");
+	fprintf(stderr,"     cifrador bench frio [opciones] (ver cifrador bench frio -h)\n");
+	fprintf(stderr,"     cifrador bench lat [opciones] (ver cifrador bench lat -h)\n");
+	fprintf(stderr,"     cifrador bench io [opciones] (ver cifrador bench io -h)\n");
+	fprintf(stderr,"     cifrador bench soak [opciones] (ver cifrador bench soak -h)\n");
+	fprintf(stderr,"     cifrador bench energia [opciones] (ver cifrador bench energia -h)\n");
+	return(1);
+	}
+
+/*
+ * Function: banco()
+ *
+ * Purpose: Entry point of "cifrador bench"
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "bench")
+ *   - char *argv[]: Arguments; argv[1] selects the mode
+ *
+ * Returns:
+ *   - int: Process exit status of the selected mode
+ */
+int banco(int argc, char *argv[])
+	{
+	if(argc < 2)
+		{
+		return(usoBanco());
+		}
+	if(strcmp(argv[1],"replay") == 0)
+		{
+		return(bancoReplay(argc-1, argv+1));
+		}
+	if(strcmp(argv[1],"rend") == 0)
+		{
+		return(bancoRend(argc-1, argv+1));
+		}
+	if(strcmp(argv[1],"frio") == 0)
+		{
+		return(bancoFrio(argc-1, argv+1));
+		}
+	if(strcmp(argv[1],"lat") == 0)
+		{
+		return(bancoLat(argc-1, argv+1));
+		}
+	if(strcmp(argv[1],"io") == 0)
+		{
+		return(bancoES(argc-1, argv+1));
+		}
+	if(strcmp(argv[1],"soak") == 0)
+		{
+		return(bancoSoak(argc-1, argv+1));
+		}
+	if(strcmp(argv[1],"energia") == 0)
+		{
+		return(bancoEnergia(argc-1, argv+1));
+		}
+	return(usoBanco());
+	}
+
+/*
+ * Function: bancoReplay()
+ *
+ * Purpose: Replays a captured trace against the in-memory COFB API
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "replay")
+ *   - char *argv[]: Options and the trace path
+ *
+ * Options:
+ *   - -v FACTOR: Replay speed relative to capture (2 = twice as fast)
+ *   - -n: Ignore arrival times and issue operations back to back
+ *
+ * Returns:
+ *   - int: 0 on success, 1 on usage or trace errors
+ *
+ * Algorithm:
+ *   1. Load and sort the records by arrival time
+ *   2. Synthesize one key per distinct handle and random payloads
+ *   3. For each record wait until its scheduled time, then run
+ *      COFBbuf() or dCOFBbuf() with the recorded block counts
+ *   4. Report service time (operation only) and response time
+ *      (service plus lateness against the schedule) percentiles,
+ *      next to the service times observed at capture
+ *
+ * Details: Each decryption runs over the ciphertext and tag of an
+ *          untimed encryption of the same record, so its tag verifies
+ *          and the failure counter stays clean
+ */
+int bancoReplay(int argc, char *argv[])
+	{
+	registro *R;
+	size_t t;
+	size_t i;
+	size_t k[nOps] = {0, 0};
+	size_t llaves;
+	double vel = 1.0;
+	byte sinEspera = 0;
+	int opc;
+	uint64_t maxA = 1;
+	uint64_t maxM = 1;
+	uint64_t a;
+	uint64_t m;
+	uint64_t bytOp[nOps] = {0, 0};
+	bloque sem = semBanco;
+	bloque e;
+	bloque K[2];
+	bloque T = 0;
+	bloques A;
+	bloques M;
+	bloques C;
+	bloques H;
+	double *serv[nOps];
+	double *resp[nOps];
+	double *capt[nOps];
+	double inicio;
+	double obj;
+	double tIni;
+	double s;
+	double total;
+	byte o;
+
+	optind = 1;
+	while((opc = getopt(argc, argv, "v:n")) != -1)
+		{
+		switch(opc)
+			{
+			case 'v':
+				vel = atof(optarg);
+				break;
+			case 'n':
+				sinEspera = 1;
+				break;
+			default:
+				return(usoBanco());
+			}
+		}
+	if(optind >= argc || vel <= 0)
+		{
+		return(usoBanco());
+		}
+
+	R = trzLeer(argv[optind], &t);
+	if(R == NULL || t == 0)
+		{
+		fprintf(stderr,"Error: la traza [%s] no es valida o esta vacia\n",argv[optind]);
+		free(R);
+		return(1);
+		}
+	qsort(R, t, sizeof(registro), cmpLlegada);
+
+	// Count distinct key handles and size the payload buffers
+	H = malloc(t * sizeof(bloque));
+	if(H == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	for(i=0;i<t;i++)
+		{
+		H[i] = R[i].llave;
+		maxA = R[i].a > maxA ? R[i].a : maxA;
+		maxM = R[i].m > maxM ? R[i].m : maxM;
+		}
+	qsort(H, t, sizeof(bloque), cmpBloque);
+	llaves = 0;
+	for(i=0;i<t;i++)
+		{
+		llaves += (i == 0 || H[i] != H[i-1]);
+		}
+	free(H);
+
+	A = malloc(maxA * sizeof(bloque));
+	M = malloc(maxM * sizeof(bloque));
+	C = malloc(maxM * sizeof(bloque));
+	for(o=0;o<nOps;o++)
+		{
+		serv[o] = malloc(t * sizeof(double));
+		resp[o] = malloc(t * sizeof(double));
+		capt[o] = malloc(t * sizeof(double));
+		if(serv[o] == NULL || resp[o] == NULL || capt[o] == NULL)
+			{
+			fprintf(stderr,"Error al asignar memoria\n");
+			exit(1);
+			}
+		}
+	if(A == NULL || M == NULL || C == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	for(i=0;i<maxA;i++)
+		{
+		A[i] = aleat(&sem);
+		}
+	for(i=0;i<maxM;i++)
+		{
+		M[i] = aleat(&sem);
+		}
+
+	inicio = metReloj();
+	for(i=0;i<t;i++)
+		{
+		o = R[i].op;
+		obj = inicio + (double)(R[i].t - R[0].t) * 1e-9 / vel;
+
+		// One synthetic key per captured handle
+		e = R[i].llave;
+		K[0] = aleat(&e);
+		K[1] = aleat(&e);
+		a = R[i].a > 0 ? R[i].a : 1;
+		m = R[i].m > 0 ? R[i].m : 1;
+
+		// A decryption gets the ciphertext and tag of a real encryption,
+		// made before the wait so it stays out of the schedule
+		if(o == opDes)
+			{
+			T = COFBbuf(K, (bloque)i, A, a, M, m, C);
+			}
+		if(sinEspera == 0)
+			{
+			esperaHasta(obj);
+			}
+
+		tIni = metReloj();
+		if(o == opCif)
+			{
+			COFBbuf(K, (bloque)i, A, a, M, m, C);
+			}
+		else
+			{
+			dCOFBbuf(K, (bloque)i, A, a, C, m, C, T);
+			}
+		s = metReloj() - tIni;
+
+		serv[o][k[o]] = s;
+		resp[o][k[o]] = s + ((sinEspera == 0 && tIni > obj) ? tIni - obj : 0);
+		capt[o][k[o]] = (double)R[i].dur * 1e-9;
+		bytOp[o] += (a + m) * n_8;
+		k[o]++;
+		}
+	total = metReloj() - inicio;
+
+	printf("replay: %zu ops, %zu llaves, traza %.3f s, reproduccion %.3f s\n",
+		t, llaves, (double)(R[t-1].t - R[0].t) * 1e-9, total);
+	printf("%-4s %10s %10s %10s | %9s %9s %9s | %9s | %9s %9s (us)\n",
+		"op","ops","ops/s","MB/s","serv p50","serv p99","serv max","resp p99","capt p50","capt p99");
+	for(o=0;o<nOps;o++)
+		{
+		if(k[o] == 0)
+			{
+			continue;
+			}
+		qsort(serv[o], k[o], sizeof(double), cmpDoble);
+		qsort(resp[o], k[o], sizeof(double), cmpDoble);
+		qsort(capt[o], k[o], sizeof(double), cmpDoble);
+		printf("%-4s %10zu %10.1f %10.3f | %9.2f %9.2f %9.2f | %9.2f | %9.2f %9.2f\n",
+			nomOp[o], k[o], (double)k[o] / total, (double)bytOp[o] / total * 1e-6,
+			percentil(serv[o],k[o],0.5) * 1e6, percentil(serv[o],k[o],0.99) * 1e6,
+			serv[o][k[o]-1] * 1e6, percentil(resp[o],k[o],0.99) * 1e6,
+			percentil(capt[o],k[o],0.5) * 1e6, percentil(capt[o],k[o],0.99) * 1e6);
+		}
+
+	for(o=0;o<nOps;o++)
+		{
+		free(serv[o]);
+		free(resp[o]);
+		free(capt[o]);
+		}
+	free(A);
+	free(M);
+	free(C);
+	free(R);
+	return(0);
+	}
+
+/*
+ * Function: mannWhitney()
+ *
+ * Purpose: Two-sided Mann-Whitney U test between two samples
+ *
+ * Parameters:
+ *   - double *x: First sample
+ *   - size_t nx: Size of the first sample
+ *   - double *y: Second sample
+ *   - size_t ny: Size of the second sample
+ *
+ * Returns:
+ *   - double: p-value of the null hypothesis that both samples come
+ *             from the same distribution
+ *
+ * Algorithm:
+ *   1. Rank the pooled sample, averaging the ranks of ties
+ *   2. U = (rank sum of x) - nx(nx+1)/2
+ *   3. Normal approximation with tie and continuity corrections:
+ *      z = (|U - nx*ny/2| - 1/2) / sigma
+ *   4. p = erfc(z / sqrt(2))
+ *
+ * Details: Makes no assumption about the shape of the distributions,
+ *          which matters for timings (skewed, with outliers)
+ */
+double mannWhitney(double *x, size_t nx, double *y, size_t ny)
+	{
+	size_t t = nx + ny;
+	size_t i;
+	size_t j;
+	size_t k;
+	double *v = malloc(t * 2 * sizeof(double));
+	double rx = 0;
+	double emp = 0;
+	double u;
+	double sig;
+	double z;
+
+	if(v == NULL || nx == 0 || ny == 0)
+		{
+		free(v);
+		return(1);
+		}
+
+	// Pairs (value, origin) sorted by value
+	for(i=0;i<t;i++)
+		{
+		v[i*2]		= i < nx ? x[i] : y[i-nx];
+		v[i*2+1]	= i < nx ? 0 : 1;
+		}
+	qsort(v, t, 2 * sizeof(double), cmpDoble);
+
+	for(i=0;i<t;i=j)
+		{
+		j = i;
+		while(j < t && v[j*2] == v[i*2])
+			{
+			j++;
+			}
+		// Tied values i..j-1 share the average rank (i+1 + j)/2
+		emp += (double)(j-i) * (double)(j-i) * (double)(j-i) - (double)(j-i);
+		for(k=i;k<j;k++)
+			{
+			rx += v[k*2+1] == 0 ? (double)(i + 1 + j) / 2 : 0;
+			}
+		}
+	free(v);
+
+	u	= rx - (double)nx * (double)(nx + 1) / 2;
+	sig	= sqrt((double)nx * (double)ny / 12 * ((double)(t + 1) - emp / ((double)t * (double)(t - 1))));
+	if(sig == 0)
+		{
+		return(1);
+		}
+	z = (fabs(u - (double)nx * (double)ny / 2) - 0.5) / sig;
+	return(z <= 0 ? 1 : erfc(z / sqrt(2)));
+	}
+
+/*
+ * Function: razonHL()
+ *
+ * Purpose: Hodges-Lehmann estimate of the ratio between two samples
+ *
+ * Parameters:
+ *   - double *x: Current sample
+ *   - size_t nx: Size of the current sample
+ *   - double *y: Baseline sample
+ *   - size_t ny: Size of the baseline sample
+ *   - double *inf: Lower bound of the 95% confidence interval (output)
+ *   - double *sup: Upper bound of the 95% confidence interval (output)
+ *
+ * Returns:
+ *   - double: Median of all pairwise ratios x[i]/y[j]
+ *
+ * Details: The interval takes the order statistics of the pairwise
+ *          ratios that correspond to the Mann-Whitney critical value,
+ *          so estimate, interval and p-value are consistent
+ */
+double razonHL(double *x, size_t nx, double *y, size_t ny, double *inf, double *sup)
+	{
+	size_t t = nx * ny;
+	size_t i;
+	size_t j;
+	double *d = malloc(t * sizeof(double));
+	double k;
+	double est;
+
+	if(d == NULL || t == 0)
+		{
+		free(d);
+		*inf = *sup = 1;
+		return(1);
+		}
+	for(i=0;i<nx;i++)
+		{
+		for(j=0;j<ny;j++)
+			{
+			d[i*ny+j] = x[i] / y[j];
+			}
+		}
+	qsort(d, t, sizeof(double), cmpDoble);
+
+	k = floor((double)t / 2 - 1.96 * sqrt((double)nx * (double)ny * (double)(nx + ny + 1) / 12));
+	k = k < 0 ? 0 : k;
+	*inf	= d[(size_t)k];
+	*sup	= d[t - 1 - (size_t)k];
+	est	= (t & 1) ? d[t/2] : (d[t/2 - 1] + d[t/2]) / 2;
+	free(d);
+	return(est);
+	}
+
+/*
+ * Function: prueba()
+ *
+ * Purpose: Runs one timed throughput trial
+ *
+ * Parameters:
+ *   - byte mot: Midori engine (motRef, motNib)
+ *   - byte op: opCif or opDes
+ *   - uint64_t m: Message blocks per operation
+ *   - double dur: Minimum trial duration in seconds
+ *   - bloques K, A, M, C: Key, one AD block, message and output buffers
+ *
+ * Returns:
+ *   - double: Message throughput in MB/s
+ */
+static double prueba(byte mot, byte op, uint64_t m, double dur, bloques K, bloques A, bloques M, bloques C)
+	{
+	uint64_t ops = 0;
+	bloque T;
+	double t0;
+	double t;
+
+	// Decryptions verify the tag of one real encryption (nonce 0); the
+	// plaintext written back into M is M itself
+	nucMot	= mot;
+	T	= COFBbuf(K, 0, A, 1, M, m, C);
+	t0	= metReloj();
+
+	do
+		{
+		if(op == opCif)
+			{
+			COFBbuf(K, ops, A, 1, M, m, C);
+			}
+		else
+			{
+			dCOFBbuf(K, 0, A, 1, C, m, M, T);
+			}
+		ops++;
+		t = metReloj() - t0;
+		}
+	while(t < dur);
+
+	return((double)(ops * m * n_8) / t * 1e-6);
+	}
+
+/*
+ * Function: leeResultados()
+ *
+ * Purpose: Loads a results file written with --guardar
+ *
+ * Parameters:
+ *   - cad ruta: Path of the results file
+ *   - size_t *t: Number of configurations loaded (output)
+ *
+ * Returns:
+ *   - resultado *: Array of results (caller frees), or NULL on error
+ *
+ * Format: One configuration per line, "#" starts a comment:
+ *         ENGINE OP BYTES TRIALS MB/s...
+ */
+static resultado * leeResultados(cad ruta, size_t *t)
+	{
+	FILE *f = fopen(ruta,"r");
+	char lin[0x1000];
+	char *p;
+	int l;
+	size_t cap = 0x10;
+	size_t i;
+	resultado *R;
+	resultado *tmp;
+	resultado x;
+
+	*t = 0;
+	R = malloc(cap * sizeof(resultado));
+	if(f == NULL || R == NULL)
+		{
+		if(f != NULL)
+			{
+			fclose(f);
+			}
+		free(R);
+		return(NULL);
+		}
+
+	while(fgets(lin, sizeof(lin), f) != NULL)
+		{
+		if(lin[0] == '#' || sscanf(lin, "%15s %7s %" SCNu64 " %zu%n", x.motor, x.op, &x.tam, &x.t, &l) != 4)
+			{
+			continue;
+			}
+		x.t = x.t > maxPr ? maxPr : x.t;
+		p = lin + l;
+		for(i=0;i<x.t;i++)
+			{
+			if(sscanf(p, "%lf%n", &x.v[i], &l) != 1)
+				{
+				break;
+				}
+			p += l;
+			}
+		x.t = i;
+		if(*t == cap)
+			{
+			cap <<= 1;
+			tmp = realloc(R, cap * sizeof(resultado));
+			if(tmp == NULL)
+				{
+				break;
+				}
+			R = tmp;
+			}
+		R[(*t)++] = x;
+		}
+	fclose(f);
+	return(R);
+	}
+
+/*
+ * Function: leeMotores()
+ *
+ * Purpose: Parses a comma-separated list of Midori engines
+ *
+ * Parameters:
+ *   - cad s: Engine labels from nomMot, e.g. "ref,ssse3"
+ *   - byte *mots: Selected engines (output, at most nMot)
+ *
+ * Returns:
+ *   - size_t: Number of engines, 0 when a label is unknown, repeated or
+ *             not supported by this CPU
+ */
+static size_t leeMotores(cad s, byte *mots)
+	{
+	size_t t = 0;
+	size_t l;
+	byte e;
+	byte j;
+
+	while(*s != 0)
+		{
+		l = strcspn(s, ",");
+		for(e=0; e<nMot && (strlen(nomMot[e]) != l || strncmp(s, nomMot[e], l) != 0); e++);
+		for(j=0; j<t && mots[j] != e; j++);
+		if(e == nMot || j < t || hayMot(e) == 0)
+			{
+			return(0);
+			}
+		mots[t++] = e;
+		s += l + (s[l] == ',');
+		}
+	return(t);
+	}
+
+/*
+ * Function: todosMotores()
+ *
+ * Purpose: Lists every engine this CPU supports
+ *
+ * Parameters:
+ *   - byte *mots: Engines (output, at most nMot)
+ *
+ * Returns:
+ *   - size_t: Number of engines
+ */
+static size_t todosMotores(byte *mots)
+	{
+	size_t t = 0;
+	byte e;
+
+	for(e=0;e<nMot;e++)
+		{
+		if(hayMot(e) != 0)
+			{
+			mots[t++] = e;
+			}
+		}
+	return(t);
+	}
+
+/*
+ * Function: usoRend()
+ *
+ * Purpose: Prints the usage of the throughput mode
+ */
+static int usoRend()
+	{
+	fprintf(stderr,"Uso: cifrador bench rend [-n pruebas] [-t segundos] [-s bytes,...] [-e motor,...]\n");
+	fprintf(stderr,"       [--guardar ARCHIVO] [--baseline ARCHIVO] [--umbral %%] [--alfa p]\n");
+	return(1);
+	}
+
+/*
+ * Function: bancoRend()
+ *
+ * Purpose: Throughput benchmark with optional regression check
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "rend")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -n TRIALS:         Trials per configuration (default 10, max maxPr)
+ *   - -t SECONDS:        Minimum duration of each trial (default 0.1)
+ *   - -s BYTES,...:      Message sizes (default 16,64,1024,16384),
+ *                        rounded up to whole 64-bit blocks
+ *   - -e ENGINE,...:     Midori engines (default every supported one)
+ *   - --guardar FILE:    Store every trial of this run in FILE
+ *   - --baseline FILE:   Compare against a run stored with --guardar
+ *   - --umbral PERCENT:  Slowdown that counts as a regression (default 5)
+ *   - --alfa P:          Significance level (default 0.01)
+ *
+ * Returns:
+ *   - int: 0 when no regression was found, 1 on usage or I/O errors,
+ *          2 when at least one configuration regressed
+ *
+ * Algorithm:
+ *   1. One configuration per (engine, op, size); the engine is
+ *      switched through nucMot and restored afterwards
+ *   2. A warm-up trial per configuration, then the measured trials
+ *      interleaved round-robin so slow drift (thermal, frequency, other
+ *      tenants) spreads over all configurations instead of biasing one
+ *   3. Against a baseline: Mann-Whitney p-value and Hodges-Lehmann
+ *      speed ratio with its 95% interval; a configuration regresses when
+ *      p < alfa and the ratio is below 1 - umbral/100
+ */
+int bancoRend(int argc, char *argv[])
+	{
+	static struct option largas[] = {
+		{"guardar",	required_argument, NULL, 'g'},
+		{"baseline",	required_argument, NULL, 'b'},
+		{"umbral",	required_argument, NULL, 'u'},
+		{"alfa",	required_argument, NULL, 'a'},
+		{NULL, 0, NULL, 0}
+		};
+	uint64_t tams[maxPr] = {16, 64, 1024, 16384};
+	size_t nTam = 4;
+	size_t nPr = 10;
+	size_t nMots;
+	size_t nConf;
+	size_t nBase = 0;
+	size_t c;
+	size_t i;
+	size_t p;
+	uint64_t maxM = 1;
+	double dur = 0.1;
+	double umbral = 5;
+	double alfa = 0.01;
+	double med;
+	double est;
+	double inf;
+	double sup;
+	double pv;
+	cad rutaG = NULL;
+	cad rutaB = NULL;
+	char *q;
+	int opc;
+	int reg = 0;
+	bloque sem = semBanco;
+	bloque K[2];
+	bloque A[1];
+	bloques M;
+	bloques C;
+	byte mots[nMot];
+	byte motIni = nucMot;
+	resultado *R;
+	resultado *B = NULL;
+	FILE *f;
+
+	nMots = todosMotores(mots);
+	optind = 1;
+	while((opc = getopt_long(argc, argv, "n:t:s:e:", largas, NULL)) != -1)
+		{
+		switch(opc)
+			{
+			case 'n':
+				nPr = strtoull(optarg, NULL, 10);
+				break;
+			case 't':
+				dur = atof(optarg);
+				break;
+			case 's':
+				nTam = 0;
+				for(q=optarg; *q != 0 && nTam < maxPr; q += (*q == ','))
+					{
+					tams[nTam++] = strtoull(q, &q, 10);
+					}
+				break;
+			case 'e':
+				if((nMots = leeMotores(optarg, mots)) == 0)
+					{
+					return(usoRend());
+					}
+				break;
+			case 'g':
+				rutaG = optarg;
+				break;
+			case 'b':
+				rutaB = optarg;
+				break;
+			case 'u':
+				umbral = atof(optarg);
+				break;
+			case 'a':
+				alfa = atof(optarg);
+				break;
+			default:
+				return(usoRend());
+			}
+		}
+	if(nPr < 2 || nPr > maxPr || nTam == 0 || dur <= 0)
+		{
+		return(usoRend());
+		}
+
+	if(rutaB != NULL && (B = leeResultados(rutaB, &nBase)) == NULL)
+		{
+		fprintf(stderr,"Error: no se pudo leer la linea base [%s]\n",rutaB);
+		return(1);
+		}
+
+	// Configurations: every op for every size and engine
+	nConf = nMots * nOps * nTam;
+	R = calloc(nConf, sizeof(resultado));
+	for(i=0;i<nTam;i++)
+		{
+		tams[i] = ((tams[i] + n_8 - 1) / n_8) * n_8;
+		tams[i] = tams[i] == 0 ? n_8 : tams[i];
+		maxM = tams[i] / n_8 > maxM ? tams[i] / n_8 : maxM;
+		}
+	M = malloc(maxM * sizeof(bloque));
+	C = malloc(maxM * sizeof(bloque));
+	if(R == NULL || M == NULL || C == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	K[0] = aleat(&sem);
+	K[1] = aleat(&sem);
+	A[0] = aleat(&sem);
+	for(i=0;i<maxM;i++)
+		{
+		M[i] = aleat(&sem);
+		}
+	for(c=0;c<nConf;c++)
+		{
+		strcpy(R[c].motor, nomMot[mots[c / (nOps * nTam)]]);
+		strcpy(R[c].op, nomOp[c % nOps]);
+		R[c].tam = tams[(c / nOps) % nTam];
+		R[c].t = nPr;
+		}
+
+	// Warm-up, then interleaved trials
+	for(c=0;c<nConf;c++)
+		{
+		prueba(mots[c / (nOps * nTam)], c % nOps, R[c].tam / n_8, dur, K, A, M, C);
+		}
+	for(p=0;p<nPr;p++)
+		{
+		for(c=0;c<nConf;c++)
+			{
+			R[c].v[p] = prueba(mots[c / (nOps * nTam)], c % nOps, R[c].tam / n_8, dur, K, A, M, C);
+			}
+		}
+	nucMot = motIni;
+
+	printf("%-6s %-4s %8s %10s %10s %10s", "motor", "op", "bytes", "MB/s p50", "min", "max");
+	printf(B != NULL ? " | %10s %8s %17s %9s\n" : "\n", "base p50", "razon", "IC 95%", "p");
+	for(c=0;c<nConf;c++)
+		{
+		double ord[maxPr];
+
+		memcpy(ord, R[c].v, nPr * sizeof(double));
+		qsort(ord, nPr, sizeof(double), cmpDoble);
+		printf("%-6s %-4s %8" PRIu64 " %10.3f %10.3f %10.3f", R[c].motor, R[c].op, R[c].tam,
+			percentil(ord, nPr, 0.5), ord[0], ord[nPr-1]);
+
+		// Locate the same configuration in the baseline
+		for(i=0; B != NULL && i<nBase; i++)
+			{
+			if(strcmp(B[i].motor, R[c].motor) == 0 && strcmp(B[i].op, R[c].op) == 0 && B[i].tam == R[c].tam && B[i].t > 1)
+				{
+				break;
+				}
+			}
+		if(B == NULL)
+			{
+			puts("");
+			continue;
+			}
+		if(i == nBase)
+			{
+			printf(" | %10s\n", "sin base");
+			continue;
+			}
+
+		memcpy(ord, B[i].v, B[i].t * sizeof(double));
+		qsort(ord, B[i].t, sizeof(double), cmpDoble);
+		med	= percentil(ord, B[i].t, 0.5);
+		est	= razonHL(R[c].v, nPr, B[i].v, B[i].t, &inf, &sup);
+		pv	= mannWhitney(R[c].v, nPr, B[i].v, B[i].t);
+		printf(" | %10.3f %7.3fx [%6.3f, %6.3f] %9.2g", med, est, inf, sup, pv);
+		if(pv < alfa && est < 1 - umbral / 100)
+			{
+			printf("  REGRESION\n");
+			reg++;
+			}
+		else if(pv < alfa && est > 1 + umbral / 100)
+			{
+			printf("  mejora\n");
+			}
+		else
+			{
+			puts("");
+			}
+		}
+
+	if(rutaG != NULL)
+		{
+		f = fopen(rutaG, "w");
+		if(f == NULL)
+			{
+			fprintf(stderr,"Error al escribir %s\n",rutaG);
+			return(1);
+			}
+		fprintf(f,"# cifrador bench rend: motor op bytes pruebas MB/s...\n");
+		for(c=0;c<nConf;c++)
+			{
+			fprintf(f,"%s %s %" PRIu64 " %zu", R[c].motor, R[c].op, R[c].tam, R[c].t);
+			for(p=0;p<R[c].t;p++)
+				{
+				fprintf(f," %.6f", R[c].v[p]);
+				}
+			fprintf(f,"\n");
+			}
+		fclose(f);
+		}
+
+	if(reg > 0)
+		{
+		fprintf(stderr,"%d configuraciones con regresion mayor al %.1f%% (alfa %g)\n", reg, umbral, alfa);
+		}
+	free(R);
+	free(B);
+	free(M);
+	free(C);
+	return(reg > 0 ? 2 : 0);
+	}
+
+/*
+ * Function: desaloja()
+ *
+ * Purpose: Evicts a memory range from every cache level
+ *
+ * Parameters:
+ *   - const void *p: Start of the range
+ *   - size_t t: Size of the range in bytes
+ *
+ * Returns: void
+ *
+ * Details: Uses clflush on x86; elsewhere it is a no-op and callers
+ *          must rely on the buffer sweep instead
+ */
+static void desaloja(const void *p, size_t t)
+	{
+#if defined(__x86_64__) || defined(__i386__)
+	const char *c = (const char *)((uintptr_t)p & ~(uintptr_t)(lineaCache - 1));
+	const char *fin = (const char *)p + t;
+
+	for(; c < fin; c += lineaCache)
+		{
+		_mm_clflush(c);
+		}
+	_mm_mfence();
+#endif
+	return;
+	}
+
+/*
+ * Function: barre()
+ *
+ * Purpose: Touches one byte per cache line of a large buffer
+ *
+ * Parameters:
+ *   - volatile byte *b: Sweep buffer (larger than the last level cache)
+ *   - size_t t: Size of the buffer in bytes
+ *
+ * Returns: void
+ *
+ * Details: Writing the lines forces them into the caches, pushing out
+ *          tables, key material, buffers and hot code
+ */
+static void barre(volatile byte *b, size_t t)
+	{
+	size_t i;
+
+	for(i=0;i<t;i+=lineaCache)
+		{
+		b[i]++;
+		}
+	return;
+	}
+
+/*
+ * Function: usoFrio()
+ *
+ * Purpose: Prints the usage of the cold-cache mode
+ */
+static int usoFrio()
+	{
+	fprintf(stderr,"Uso: cifrador bench frio [-n ops] [-k llaves] [-s bytes,...] [-e motor,...] [-d clflush|barrido] [-b MiB]\n");
+	return(1);
+	}
+
+/*
+ * Function: bancoFrio()
+ *
+ * Purpose: Per-operation latency under cold caches and key switching
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "frio")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -n OPS:        Operations per scenario (default 2000)
+ *   - -k KEYS:       Size of the rotating key set (default 65536)
+ *   - -s BYTES,...:  Message sizes (default 16,64,1024)
+ *   - -e ENG,...:    Midori engines from nomMot (default: every
+ *                    supported one); switched through nucMot
+ *   - -d METHOD:     "clflush" (x86 default) flushes the buffers, the
+ *                    key of the next operation and the lookup tables
+ *                    (nucTablas()); "barrido" sweeps a buffer larger than
+ *                    the last level cache
+ *   - -b MIB:        Size of the sweep buffer (default 64)
+ *
+ * Returns:
+ *   - int: 0 on success, 1 on usage errors
+ *
+ * Scenarios (each op is timed individually, eviction is not timed):
+ *   - caliente:  same key and buffers every operation (warm loop)
+ *   - llaves:    next key of a randomly ordered set per operation
+ *   - frio:      same key, caches evicted before every operation
+ *   - frio+llaves: both, i.e. the typical first request of a client
+ */
+int bancoFrio(int argc, char *argv[])
+	{
+	uint64_t tams[maxPr] = {16, 64, 1024};
+	size_t nTam = 3;
+	size_t nOpsF = 2000;
+	size_t nLlaves = 0x10000;
+	size_t tBarr = (size_t)64 << 20;
+	size_t nMots;
+	size_t i;
+	size_t j;
+	size_t e;
+	size_t w;
+	size_t x;
+	uint64_t m;
+	uint64_t maxM = 1;
+	byte mots[nMot];
+	byte motIni = nucMot;
+	byte barrido = 0;
+	byte nTab;
+	byte frio;
+	byte rota;
+	int opc;
+	char *q;
+	bloque sem = semBanco;
+	bloques L;
+	bloques A;
+	bloques M;
+	bloques C;
+	bloques K;
+	size_t *ord;
+	byte *b = NULL;
+	double *lat;
+	double t0;
+	const void *tab[maxTab];
+	size_t tTab[maxTab];
+	static const char * nomEsc[4] = {"caliente", "llaves", "frio", "frio+llaves"};
+
+#if !defined(__x86_64__) && !defined(__i386__)
+	barrido = 1;
+#endif
+	nMots = todosMotores(mots);
+	nTab = nucTablas(tab, tTab);
+	optind = 1;
+	while((opc = getopt(argc, argv, "n:k:s:e:d:b:")) != -1)
+		{
+		switch(opc)
+			{
+			case 'n':
+				nOpsF = strtoull(optarg, NULL, 10);
+				break;
+			case 'k':
+				nLlaves = strtoull(optarg, NULL, 10);
+				break;
+			case 's':
+				nTam = 0;
+				for(q=optarg; *q != 0 && nTam < maxPr; q += (*q == ','))
+					{
+					tams[nTam++] = strtoull(q, &q, 10);
+					}
+				break;
+			case 'e':
+				if((nMots = leeMotores(optarg, mots)) == 0)
+					{
+					return(usoFrio());
+					}
+				break;
+			case 'd':
+				barrido = strcmp(optarg, "barrido") == 0;
+				if(barrido == 0 && strcmp(optarg, "clflush") != 0)
+					{
+					return(usoFrio());
+					}
+				break;
+			case 'b':
+				tBarr = (size_t)strtoull(optarg, NULL, 10) << 20;
+				break;
+			default:
+				return(usoFrio());
+			}
+		}
+	if(nOpsF == 0 || nLlaves == 0 || nTam == 0 || tBarr == 0)
+		{
+		return(usoFrio());
+		}
+
+	for(i=0;i<nTam;i++)
+		{
+		tams[i] = tams[i] < n_8 ? n_8 : ((tams[i] + n_8 - 1) / n_8) * n_8;
+		maxM = tams[i] / n_8 > maxM ? tams[i] / n_8 : maxM;
+		}
+	L	= malloc(nLlaves * 2 * sizeof(bloque));
+	ord	= malloc(nLlaves * sizeof(size_t));
+	A	= malloc(sizeof(bloque));
+	M	= malloc(maxM * sizeof(bloque));
+	C	= malloc(maxM * sizeof(bloque));
+	lat	= malloc(nOpsF * sizeof(double));
+	if(barrido != 0)
+		{
+		b = calloc(tBarr, 1);
+		}
+	if(L == NULL || ord == NULL || A == NULL || M == NULL || C == NULL || lat == NULL || (barrido != 0 && b == NULL))
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+
+	// Key set visited in a random permutation so prefetchers cannot help
+	for(i=0;i<nLlaves;i++)
+		{
+		L[i*2]		= aleat(&sem);
+		L[i*2+1]	= aleat(&sem);
+		ord[i]		= i;
+		}
+	for(i=nLlaves-1;i>0;i--)
+		{
+		j	= aleat(&sem) % (i + 1);
+		x	= ord[i];
+		ord[i]	= ord[j];
+		ord[j]	= x;
+		}
+	A[0] = aleat(&sem);
+	for(i=0;i<maxM;i++)
+		{
+		M[i] = aleat(&sem);
+		}
+
+	printf("desalojo: %s, %zu llaves (%zu KiB)\n", barrido ? "barrido" : "clflush", nLlaves, nLlaves * 2 * sizeof(bloque) >> 10);
+	printf("%-6s %-12s %8s %9s %9s %9s %9s %9s (us)\n", "motor", "escenario", "bytes", "p50", "p90", "p99", "p99.9", "max");
+	for(x=0;x<nMots;x++)
+		{
+		nucMot = mots[x];
+		for(j=0;j<nTam;j++)
+			{
+			m = tams[j] / n_8;
+			for(e=0;e<4;e++)
+				{
+				rota = e & 1;
+				frio = e >> 1;
+				for(i=0;i<nOpsF;i++)
+					{
+					K = rota ? &L[ord[i % nLlaves] * 2] : L;
+					if(frio != 0 && barrido != 0)
+						{
+						barre(b, tBarr);
+						}
+					else if(frio != 0)
+						{
+						desaloja(K, 2 * sizeof(bloque));
+						desaloja(A, sizeof(bloque));
+						desaloja(M, m * sizeof(bloque));
+						desaloja(C, m * sizeof(bloque));
+						for(w=0;w<nTab;w++)
+							{
+							desaloja(tab[w], tTab[w]);
+							}
+						}
+					t0 = metReloj();
+					COFBbuf(K, i, A, 1, M, m, C);
+					lat[i] = metReloj() - t0;
+					}
+				qsort(lat, nOpsF, sizeof(double), cmpDoble);
+				printf("%-6s %-12s %8" PRIu64 " %9.2f %9.2f %9.2f %9.2f %9.2f\n", nomMot[nucMot], nomEsc[e], tams[j],
+					percentil(lat, nOpsF, 0.5) * 1e6, percentil(lat, nOpsF, 0.9) * 1e6,
+					percentil(lat, nOpsF, 0.99) * 1e6, percentil(lat, nOpsF, 0.999) * 1e6,
+					lat[nOpsF-1] * 1e6);
+				}
+			}
+		}
+	nucMot = motIni;
+
+	free(L);
+	free(ord);
+	free(A);
+	free(M);
+	free(C);
+	free(lat);
+	free(b);
+	return(0);
+	}
+
+/*
+ * Function: usoLat()
+ *
+ * Purpose: Prints the usage of the engine latency mode
+ */
+static int usoLat()
+	{
+	fprintf(stderr,"Uso: cifrador bench lat [-n muestras] [-s bytes,...] [-e motor,...] [-g]\n");
+	return(1);
+	}
+
+/*
+ * Function: bancoLat()
+ *
+ * Purpose: Single-message latency of every Midori engine
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "lat")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -n SAMPLES:    Samples per row (default 10000)
+ *   - -s BYTES,...:  Message sizes (default 8,16,64)
+ *   - -e ENGINE,...: Engines (default every supported one); the first
+ *                    one is the reference of the speed-up column
+ *   - -g:            Generic COFB path only (fixed shapes otherwise run
+ *                    the unrolled kernel)
+ *
+ * Returns:
+ *   - int: 0 on success, 1 on usage errors
+ *
+ * Rows per engine (warm caches, one key):
+ *   - bloque: one Midori call inside a dependency chain (each input is
+ *             the previous output, as in the COFB chain); a sample times
+ *             latLote chained calls and is divided by latLote
+ *   - BYTES:  one COFBbuf() with one AD block, timed individually
+ *
+ * Rows per batch kernel (lote.h, every one this CPU supports):
+ *   - lote:   one midoriLote() call on loteMax independent blocks; a
+ *             sample times latLote calls and is divided by the blocks
+ *             encrypted, so the speed-up column compares it with the
+ *             chained bloque row of the first engine
+ *
+ * Details: The median cost of reading the clock is measured first and
+ *          subtracted from every sample
+ */
+int bancoLat(int argc, char *argv[])
+	{
+	uint64_t tams[maxPr] = {8, 16, 64};
+	size_t nTam = 3;
+	size_t nMu = 10000;
+	size_t nMots;
+	size_t e;
+	size_t w;
+	size_t i;
+	size_t j;
+	size_t k;
+	uint64_t m;
+	uint64_t maxM = 1;
+	int opc;
+	char *q;
+	bloque sem = semBanco;
+	bloque K[2];
+	bloque A[1];
+	bloques M;
+	bloques C;
+	bloque Y;
+	bloque B[loteMax];
+	llaveExp L;
+	llaveNib X;
+	llaveLote XL;
+	byte mots[nMot];
+	byte motIni = nucMot;
+	byte loteIniMot = loteMot;
+	byte espIni = cofbEsp;
+	double *lat;
+	double base[maxPr + 1];
+	double vacio;
+	double med;
+	double t0;
+	volatile bloque sumidero;
+
+	nMots = todosMotores(mots);
+	optind = 1;
+	while((opc = getopt(argc, argv, "n:s:e:g")) != -1)
+		{
+		switch(opc)
+			{
+			case 'n':
+				nMu = strtoull(optarg, NULL, 10);
+				break;
+			case 's':
+				nTam = 0;
+				for(q=optarg; *q != 0 && nTam < maxPr; q += (*q == ','))
+					{
+					tams[nTam++] = strtoull(q, &q, 10);
+					}
+				break;
+			case 'e':
+				if((nMots = leeMotores(optarg, mots)) == 0)
+					{
+					return(usoLat());
+					}
+				break;
+			case 'g':
+				cofbEsp = 0;
+				break;
+			default:
+				return(usoLat());
+			}
+		}
+	if(nMu == 0 || nTam == 0)
+		{
+		return(usoLat());
+		}
+
+	for(i=0;i<nTam;i++)
+		{
+		tams[i] = tams[i] < n_8 ? n_8 : ((tams[i] + n_8 - 1) / n_8) * n_8;
+		maxM = tams[i] / n_8 > maxM ? tams[i] / n_8 : maxM;
+		}
+	M	= malloc(maxM * sizeof(bloque));
+	C	= malloc(maxM * sizeof(bloque));
+	lat	= malloc(nMu * sizeof(double));
+	if(M == NULL || C == NULL || lat == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	K[0] = aleat(&sem);
+	K[1] = aleat(&sem);
+	A[0] = aleat(&sem);
+	for(i=0;i<maxM;i++)
+		{
+		M[i] = aleat(&sem);
+		}
+	expandeLlave(&L, K);
+	desempacaLlave(&X, &L);
+	desempacaLote(&XL, &L);
+	for(i=0;i<loteMax;i++)
+		{
+		B[i] = aleat(&sem);
+		}
+
+	// Cost of the clock itself
+	for(i=0;i<nMu;i++)
+		{
+		t0 = metReloj();
+		lat[i] = metReloj() - t0;
+		}
+	qsort(lat, nMu, sizeof(double), cmpDoble);
+	vacio = percentil(lat, nMu, 0.5);
+
+	printf("reloj: %.1f ns por lectura (descontado)\n", vacio * 1e9);
+	printf("%-6s %8s %9s %9s %9s %9s %9s (ns) %8s\n", "motor", "carga", "p50", "p90", "p99", "p99.9", "max", "vs base");
+	for(e=0;e<nMots;e++)
+		{
+		nucMot = mots[e];
+		for(w=0;w<=nTam;w++)
+			{
+			m = (w == 0) ? 0 : tams[w-1] / n_8;
+			Y = sem;
+			// Warm-up pass, then the timed samples
+			for(k=0; k<2; k++)
+				{
+				for(i=0; i < (k == 0 ? (nMu >> 4) + 1 : nMu); i++)
+					{
+					if(w == 0)
+						{
+						t0 = metReloj();
+						for(j=0;j<latLote;j++)
+							{
+							Y = (mots[e] == motNib) ? midoriNib(Y, &X) : midoriExp(Y, &L, 0);
+							}
+						lat[i] = (metReloj() - t0 - vacio) / latLote;
+						}
+					else
+						{
+						t0 = metReloj();
+						Y ^= COFBbuf(K, i, A, 1, M, m, C);
+						lat[i] = metReloj() - t0 - vacio;
+						}
+					lat[i] = lat[i] < 0 ? 0 : lat[i];
+					}
+				}
+			sumidero = Y;
+			qsort(lat, nMu, sizeof(double), cmpDoble);
+			med = percentil(lat, nMu, 0.5);
+			base[w] = (e == 0) ? med : base[w];
+			if(w == 0)
+				{
+				printf("%-6s %8s", nomMot[mots[e]], "bloque");
+				}
+			else
+				{
+				printf("%-6s %8" PRIu64, nomMot[mots[e]], tams[w-1]);
+				}
+			printf(" %9.1f %9.1f %9.1f %9.1f %9.1f      %7.2fx\n", med * 1e9,
+				percentil(lat, nMu, 0.9) * 1e9, percentil(lat, nMu, 0.99) * 1e9,
+				percentil(lat, nMu, 0.999) * 1e9, lat[nMu-1] * 1e9, med > 0 ? base[w] / med : 0);
+			}
+		}
+	for(e=0;e<nLote;e++)
+		{
+		if(!hayLote((byte)e))
+			{
+			continue;
+			}
+		loteMot = (byte)e;
+		for(k=0; k<2; k++)
+			{
+			for(i=0; i < (k == 0 ? (nMu >> 4) + 1 : nMu); i++)
+				{
+				t0 = metReloj();
+				for(j=0;j<latLote;j++)
+					{
+					midoriLote(&XL, B, loteMax, B);
+					}
+				lat[i] = (metReloj() - t0 - vacio) / (latLote * loteMax);
+				lat[i] = lat[i] < 0 ? 0 : lat[i];
+				}
+			}
+		sumidero = B[0];
+		qsort(lat, nMu, sizeof(double), cmpDoble);
+		med = percentil(lat, nMu, 0.5);
+		printf("%-6s %8s %9.1f %9.1f %9.1f %9.1f %9.1f      %7.2fx\n", nomLote[e], "lote", med * 1e9,
+			percentil(lat, nMu, 0.9) * 1e9, percentil(lat, nMu, 0.99) * 1e9,
+			percentil(lat, nMu, 0.999) * 1e9, lat[nMu-1] * 1e9, med > 0 ? base[0] / med : 0);
+		}
+	(void)sumidero;
+	nucMot = motIni;
+	loteMot = loteIniMot;
+	cofbEsp = espIni;
+
+	free(M);
+	free(C);
+	free(lat);
+	return(0);
+	}
+
+/*
+ * Function: sueltaCache()
+ *
+ * Purpose: Drops the cached pages of a file
+ *
+ * Parameters:
+ *   - int fd: Descriptor of the file
+ *
+ * Returns:
+ *   - 0: Pages dropped (dirty pages are written back first)
+ *   - 1: Not supported or failed
+ */
+static byte sueltaCache(int fd)
+	{
+#ifdef POSIX_FADV_DONTNEED
+	return(fdatasync(fd) != 0 || posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0);
+#else
+	return(1);
+#endif
+	}
+
+/*
+ * Function: cpuSeg()
+ *
+ * Purpose: CPU time consumed by the process, all threads included
+ *
+ * Returns:
+ *   - double: User plus system time in seconds
+ */
+static double cpuSeg()
+	{
+	struct rusage u;
+
+	getrusage(RUSAGE_SELF, &u);
+	return((double)(u.ru_utime.tv_sec + u.ru_stime.tv_sec)
+		+ (double)(u.ru_utime.tv_usec + u.ru_stime.tv_usec) * 1e-6);
+	}
+
+/*
+ * Function: creaEntradas()
+ *
+ * Purpose: Writes the binary and hex input files of the I/O benchmark
+ *
+ * Parameters:
+ *   - cad rBin: Path of the binary file
+ *   - cad rHex: Path of the hex file (stdio and hex modes)
+ *   - uint64_t tam: Payload bytes (multiple of 8)
+ *   - bloque *sem: aleat() state
+ *
+ * Returns:
+ *   - 0: Both files written and synced, so they can be evicted
+ *   - 1: I/O error
+ */
+static byte creaEntradas(cad rBin, cad rHex, uint64_t tam, bloque *sem)
+	{
+	int fb = open(rBin, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	int fh = open(rHex, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	bloques B = malloc(arcTrozo);
+	bytes b = malloc(arcTrozo);
+	char *h = malloc((arcTrozo << 1) + 1);
+	size_t t;
+	size_t i;
+	byte err = (fb < 0 || fh < 0);
+
+	if(B == NULL || b == NULL || h == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	while(tam > 0 && err == 0)
+		{
+		t = tam < arcTrozo ? (size_t)tam : arcTrozo;
+		for(i=0;i<t/n_8;i++)
+			{
+			B[i] = aleat(sem);
+			sprintf(h + (i << 4), "%016" PRIx64, B[i]);
+			}
+		guardaBEs(B, b, t / n_8);
+		err = escTodo(fb, b, t) | escTodo(fh, (bytes)h, t << 1);
+		tam -= t;
+		}
+	err |= (fb >= 0 && fsync(fb) != 0) | (fh >= 0 && fsync(fh) != 0);
+	if(fb >= 0)
+		{
+		close(fb);
+		}
+	if(fh >= 0)
+		{
+		close(fh);
+		}
+	free(B);
+	free(b);
+	free(h);
+	return(err);
+	}
+
+/*
+ * Function: usoES()
+ *
+ * Purpose: Prints the usage of the I/O path mode
+ */
+static int usoES()
+	{
+	fprintf(stderr,"Uso: cifrador bench io [-n pruebas] [-s bytes,...] [-d dir] [-c caliente|frio|ambos] [-x]\n");
+	return(1);
+	}
+
+/*
+ * Function: bancoES()
+ *
+ * Purpose: Compares the I/O paths of archivo.c on a file encryption
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "io")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -n TRIALS:     Runs per (mode, cache, size), median reported
+ *                    (default 3)
+ *   - -s BYTES,...:  File sizes (default 262144, rounded up to 8 bytes)
+ *   - -d DIR:        Directory of the scratch files (default $TMPDIR
+ *                    or /tmp); pick the file system under test
+ *   - -c STATE:      Page cache before each run: "caliente" (input read
+ *                    beforehand), "frio" (posix_fadvise DONTNEED) or
+ *                    "ambos" (default)
+ *   - -x:            Copy the blocks without encrypting, isolating the
+ *                    I/O path from the reference engine
+ *
+ * Returns:
+ *   - int: 0 on success, 1 on usage or I/O errors
+ *
+ * Details:
+ *   - GB/s counts binary payload bytes over wall time; the stdio and
+ *     hex modes move twice as many characters for the same payload
+ *   - CPU ns/B divides user plus system time of every thread by the
+ *     payload, so a path can be fast yet expensive (e.g. polling)
+ *   - Every mode must produce the same tag; a mismatch is reported
+ *   - Modes the system lacks (io_uring under a seccomp filter, ...)
+ *     are listed as unavailable
+ */
+int bancoES(int argc, char *argv[])
+	{
+	uint64_t tams[maxPr] = {0x40000};
+	size_t nTam = 1;
+	size_t nPr = 3;
+	size_t j;
+	size_t p;
+	byte modo;
+	byte est;
+	byte estIni = 0;
+	byte estFin = 1;
+	byte copia = 0;
+	byte res = arcOk;
+	int opc;
+	int fdE;
+	int fdS;
+	char *q;
+	cad dir = getenv("TMPDIR");
+	char rBin[0x200];
+	char rHex[0x200];
+	char rSal[0x200];
+	bloque sem = semBanco;
+	bloque K[2];
+	bloque A[1];
+	bloque T;
+	bloque Tref = 0;
+	byte hayRef;
+	bytes b;
+	cofbEdo E;
+	double gbs[maxPr];
+	double cpu[maxPr];
+	double t0;
+	double c0;
+	static const char * nomEst[2] = {"caliente", "frio"};
+
+	optind = 1;
+	while((opc = getopt(argc, argv, "n:s:d:c:x")) != -1)
+		{
+		switch(opc)
+			{
+			case 'n':
+				nPr = strtoull(optarg, NULL, 10);
+				break;
+			case 's':
+				nTam = 0;
+				for(q=optarg; *q != 0 && nTam < maxPr; q += (*q == ','))
+					{
+					tams[nTam++] = strtoull(q, &q, 10);
+					}
+				break;
+			case 'd':
+				dir = optarg;
+				break;
+			case 'c':
+				estIni = strcmp(optarg, "frio") == 0;
+				estFin = strcmp(optarg, "caliente") == 0 ? 0 : 1;
+				if(strcmp(optarg, "ambos") != 0 && strcmp(optarg, "frio") != 0 && strcmp(optarg, "caliente") != 0)
+					{
+					return(usoES());
+					}
+				break;
+			case 'x':
+				copia = 1;
+				break;
+			default:
+				return(usoES());
+			}
+		}
+	if(nPr == 0 || nPr > maxPr || nTam == 0)
+		{
+		return(usoES());
+		}
+	if(dir == NULL)
+		{
+		dir = "/tmp";
+		}
+	snprintf(rBin, sizeof(rBin), "%s/cofb-io-%d.bin", dir, (int)getpid());
+	snprintf(rHex, sizeof(rHex), "%s/cofb-io-%d.hex", dir, (int)getpid());
+	snprintf(rSal, sizeof(rSal), "%s/cofb-io-%d.sal", dir, (int)getpid());
+	b = malloc(arcTrozo);
+	if(b == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	K[0] = aleat(&sem);
+	K[1] = aleat(&sem);
+	A[0] = aleat(&sem);
+
+	printf("%s, %zu pruebas, trozo %d KiB\n", copia ? "solo E/S" : "cifrado ref", nPr, arcTrozo >> 10);
+	printf("%-6s %-9s %10s %10s %10s\n", "modo", "cache", "bytes", "GB/s p50", "CPU ns/B");
+	for(j=0;j<nTam;j++)
+		{
+		tams[j] = ((tams[j] + n_8 - 1) / n_8) * n_8;
+		if(tams[j] == 0 || creaEntradas(rBin, rHex, tams[j], &sem) != 0)
+			{
+			fprintf(stderr,"Error al crear los archivos en %s\n", dir);
+			unlink(rBin);
+			unlink(rHex);
+			free(b);
+			return(1);
+			}
+		hayRef = 0;
+		for(modo=0;modo<nArc;modo++)
+			{
+			for(est=estIni;est<=estFin;est++)
+				{
+				for(p=0;p<nPr;p++)
+					{
+					fdE = open(modo == arcStdio || modo == arcHex ? rHex : rBin, O_RDONLY);
+					fdS = open(rSal, O_RDWR | O_CREAT | O_TRUNC, 0600);
+					if(fdE < 0 || fdS < 0)
+						{
+						fprintf(stderr,"Error al abrir los archivos en %s\n", dir);
+						exit(1);
+						}
+					// Warm: pull the input into the page cache; cold: drop it
+					if(est == 0)
+						{
+						while(leeTodo(fdE, b, arcTrozo) == arcTrozo);
+						lseek(fdE, 0, SEEK_SET);
+						}
+					else if(sueltaCache(fdE) != 0)
+						{
+						fprintf(stderr,"Aviso: no se pudo desalojar la cache de paginas\n");
+						}
+
+					if(copia == 0)
+						{
+						COFBini(&E, opCif, K, 0, A, 1);
+						}
+					c0 = cpuSeg();
+					t0 = metReloj();
+					res = arcCifra(modo, fdE, fdS, tams[j], copia ? NULL : &E);
+					T = copia ? 0 : COFBfin(&E, 0);
+					gbs[p] = (double)tams[j] / (metReloj() - t0) * 1e-9;
+					cpu[p] = (cpuSeg() - c0) * 1e9 / (double)tams[j];
+					close(fdE);
+					close(fdS);
+					if(res != arcOk)
+						{
+						break;
+						}
+					// Reference tag: the first mode that completes at this size
+					if(hayRef == 0)
+						{
+						Tref = T;
+						hayRef = 1;
+						}
+					else if(T != Tref)
+						{
+						fprintf(stderr,"Aviso: %s produjo la etiqueta %016" PRIx64 " en lugar de %016" PRIx64 "\n",
+							nomArc[modo], T, Tref);
+						}
+					}
+				if(res == arcNoDisp)
+					{
+					printf("%-6s %-9s %10" PRIu64 " %21s\n", nomArc[modo], nomEst[est], tams[j], "no disponible");
+					break;
+					}
+				if(res != arcOk)
+					{
+					printf("%-6s %-9s %10" PRIu64 " %21s\n", nomArc[modo], nomEst[est], tams[j], "error de E/S");
+					continue;
+					}
+				qsort(gbs, nPr, sizeof(double), cmpDoble);
+				qsort(cpu, nPr, sizeof(double), cmpDoble);
+				printf("%-6s %-9s %10" PRIu64 " %10.5f %10.2f\n", nomArc[modo], nomEst[est], tams[j],
+					percentil(gbs, nPr, 0.5), percentil(cpu, nPr, 0.5));
+				}
+			}
+		}
+
+	unlink(rBin);
+	unlink(rHex);
+	unlink(rSal);
+	free(b);
+	return(0);
+	}
+
+/*
+ * Function: memRSS()
+ *
+ * Purpose: Resident set size of the process
+ *
+ * Returns:
+ *   - uint64_t: KiB resident, 0 when /proc/self/statm is unavailable
+ */
+static uint64_t memRSS()
+	{
+	unsigned long long tot = 0;
+	unsigned long long res = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+
+	if(f == NULL)
+		{
+		return(0);
+		}
+	if(fscanf(f, "%llu %llu", &tot, &res) != 2)
+		{
+		res = 0;
+		}
+	fclose(f);
+	return((uint64_t)res * (uint64_t)sysconf(_SC_PAGESIZE) / 1024);
+	}
+
+/*
+ * Function: memHeap()
+ *
+ * Purpose: Heap bytes currently allocated through malloc()
+ *
+ * Returns:
+ *   - uint64_t: KiB in use (arenas plus mmap-ed chunks), 0 when the C
+ *               library has no mallinfo2() (glibc before 2.33)
+ */
+static uint64_t memHeap()
+	{
+#ifdef soakMallinfo
+	struct mallinfo2 mi = mallinfo2();
+
+	return((uint64_t)(mi.uordblks + mi.hblkhd) / 1024);
+#else
+	return(0);
+#endif
+	}
+
+/*
+ * Function: pendiente()
+ *
+ * Purpose: Least-squares slope of y against its index
+ */
+static double pendiente(double *y, size_t t)
+	{
+	size_t i;
+	double mx = (t - 1) / 2.0;
+	double my = 0;
+	double sxy = 0;
+	double sxx = 0;
+
+	for(i=0;i<t;i++)
+		{
+		my += y[i] / t;
+		}
+	for(i=0;i<t;i++)
+		{
+		sxy += (i - mx) * (y[i] - my);
+		sxx += (i - mx) * (i - mx);
+		}
+	return(sxx > 0 ? sxy / sxx : 0);
+	}
+
+/*
+ * Function: soakOp()
+ *
+ * Purpose: One operation of the soak mix, checked for correctness
+ *
+ * Parameters:
+ *   - bloque *sem: Generator state (keys, nonces, sizes, payloads)
+ *   - size_t maxM: Largest message in blocks
+ *   - bloques M, C, D: Message, output and check buffers (maxM blocks)
+ *   - uint64_t *proc: Message bytes processed (accumulated)
+ *
+ * Returns:
+ *   - 0: Result verified
+ *   - 1: Wrong result
+ *
+ * Mix (1/8 each unless stated):
+ *   - 3/8 batch API: COFBbuf() then vCOFBbuf()
+ *   - forged ciphertext: vCOFBbuf() must reject it and wipe the output
+ *   - 2/8 streaming API: COFBini()/COFBsig()/COFBfin() in random chunks,
+ *     both directions, compared with COFBbuf()
+ *   - batch kernel: midoriLote() spot-checked against midoriExp()
+ *   - vector helpers: the tag through cadToVect() and libVect()
+ *
+ * Details: Half of the messages take the 16-128 byte packet sizes of the
+ *          specialized shapes, the rest 1 to maxM blocks; 1 to 3 AD
+ *          blocks and a new key and nonce every time
+ */
+static byte soakOp(bloque *sem, size_t maxM, bloques M, bloques C, bloques D, uint64_t *proc)
+	{
+	size_t a;
+	size_t m;
+	size_t i;
+	size_t c;
+	bloque K[2];
+	bloque A[3];
+	bloque N;
+	bloque T;
+	llaveExp L;
+	llaveLote XL;
+	cofbEdo E;
+	char hex[0x11];
+	vect V;
+	byte tipo;
+	byte fallo = 0;
+
+	K[0] = aleat(sem);
+	K[1] = aleat(sem);
+	N = aleat(sem);
+	a = 1 + aleat(sem) % 3;
+	for(i=0;i<a;i++)
+		{
+		A[i] = aleat(sem);
+		}
+	tipo = (byte)(aleat(sem) & 7);
+	m = (aleat(sem) & 1) ? (size_t)2 << (aleat(sem) & 3) : 1 + aleat(sem) % maxM;
+	m = m > maxM ? maxM : m;
+	for(i=0;i<m;i++)
+		{
+		M[i] = aleat(sem);
+		}
+	*proc += m * n_8;
+
+	switch(tipo)
+		{
+		case 0:
+		case 1:
+		case 2:
+			T = COFBbuf(K, N, A, a, M, m, C);
+			fallo = vCOFBbuf(K, N, A, a, C, m, D, T) != 0 || memcmp(D, M, m * sizeof(bloque)) != 0;
+			break;
+		case 3:
+			T = COFBbuf(K, N, A, a, M, m, C);
+			C[aleat(sem) % m] ^= (bloque)1 << (aleat(sem) & 0x3f);
+			fallo = vCOFBbuf(K, N, A, a, C, m, D, T) != 1 || D[0] != 0;
+			break;
+		case 4:
+		case 5:
+			T = COFBbuf(K, N, A, a, M, m, D);
+			COFBini(&E, opCif, K, N, A, a);
+			for(i=0;i<m;i+=c)
+				{
+				c = 1 + aleat(sem) % (m - i);
+				COFBsig(&E, M + i, c, C + i);
+				}
+			fallo = COFBfin(&E, 0) != T || memcmp(C, D, m * sizeof(bloque)) != 0;
+			COFBini(&E, opDes, K, N, A, a);
+			for(i=0;i<m;i+=c)
+				{
+				c = 1 + aleat(sem) % (m - i);
+				COFBsig(&E, C + i, c, D + i);
+				}
+			fallo |= COFBfin(&E, T) != T || memcmp(D, M, m * sizeof(bloque)) != 0;
+			break;
+		case 6:
+			expandeLlave(&L, K);
+			desempacaLote(&XL, &L);
+			midoriLote(&XL, M, m, C);
+			i = aleat(sem) % m;
+			fallo = C[i] != midoriExp(M[i], &L, 0);
+			break;
+		default:
+			T = COFBbuf(K, N, A, a, M, m, C);
+			snprintf(hex, sizeof(hex), "%016" PRIx64, T);
+			V = cadToVect(hex);
+			for(i=0;i<n_8;i++)
+				{
+				fallo |= V->v[i] != (byte)(T >> (56 - 8 * i));
+				}
+			libVect(V);
+		}
+	return(fallo);
+	}
+
+/*
+ * Function: usoSoak()
+ *
+ * Purpose: Prints the usage of the soak mode
+ */
+static int usoSoak()
+	{
+	fprintf(stderr,"Uso: cifrador bench soak [-d segundos] [-i segundos] [-s bytes] [-e motor]\n");
+	fprintf(stderr,"       [--umbral %%] [--alfa p] [--holgura KiB]\n");
+	return(1);
+	}
+
+/*
+ * Function: bancoSoak()
+ *
+ * Purpose: Long-running mixed workload that watches throughput, latency
+ *          and memory for drift
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "soak")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -d SECONDS:       Total duration (default 3600)
+ *   - -i SECONDS:       Sampling interval (default 10)
+ *   - -s BYTES:         Largest message (default 1024)
+ *   - -e ENGINE:        Midori engine (default the selected one)
+ *   - --umbral PERCENT: Throughput loss or p99 growth that counts as
+ *                       drift (default 5)
+ *   - --alfa P:         Significance level (default 0.01)
+ *   - --holgura KiB:    RSS or heap growth that counts as drift
+ *                       (default 1024)
+ *
+ * Returns:
+ *   - int: 0 when stable, 1 on usage errors, 2 on drift, 3 when an
+ *          operation returned a wrong result
+ *
+ * Algorithm:
+ *   1. Operations from soakOp() run back to back; one row per interval
+ *      with ops/s, MB/s, latency percentiles (reservoir of soakMu
+ *      samples), RSS, heap in use and wrong results
+ *   2. Interval 0 is warm-up; the next w = max(soakVent, intervals/4)
+ *      form the reference window. Later rows are marked when below the
+ *      reference median throughput by umbral percent, or above the
+ *      reference memory by holgura
+ *   3. At the end the last w intervals are compared with the reference
+ *      window: Mann-Whitney p-value and Hodges-Lehmann ratio of ops/s
+ *      and of p99 as in bench rend, plus the growth of RSS and heap
+ *      over the reference maximum. Slopes per hour are reported too
+ */
+int bancoSoak(int argc, char *argv[])
+	{
+	static struct option largas[] = {
+		{"umbral",	required_argument, NULL, 'u'},
+		{"alfa",	required_argument, NULL, 'a'},
+		{"holgura",	required_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+		};
+	double dur = 3600;
+	double intervalo = 10;
+	double umbral = 5;
+	double alfa = 0.01;
+	double holgura = 1024;
+	uint64_t tam = 1024;
+	size_t maxM;
+	size_t nInt;
+	size_t w;
+	size_t k;
+	size_t j;
+	size_t nLat;
+	uint64_t ops;
+	uint64_t opsTot = 0;
+	uint64_t proc;
+	uint64_t fallos = 0;
+	uint64_t fInt;
+	int opc;
+	int deriva = 0;
+	bloque sem = semBanco;
+	bloques M;
+	bloques C;
+	bloques D;
+	byte mots[nMot];
+	byte motIni = nucMot;
+	double *lat;
+	double *tasa;
+	double *p99;
+	double *rss;
+	double *heap;
+	double tIni;
+	double tOp;
+	double ahora;
+	double el;
+	double baseTasa = 0;
+	double baseRSS = 0;
+	double baseHeap = 0;
+	double pv;
+	double est;
+	double inf;
+	double sup;
+
+	optind = 1;
+	while((opc = getopt_long(argc, argv, "d:i:s:e:", largas, NULL)) != -1)
+		{
+		switch(opc)
+			{
+			case 'd':
+				dur = atof(optarg);
+				break;
+			case 'i':
+				intervalo = atof(optarg);
+				break;
+			case 's':
+				tam = strtoull(optarg, NULL, 10);
+				break;
+			case 'e':
+				if(leeMotores(optarg, mots) == 0)
+					{
+					return(usoSoak());
+					}
+				nucMot = mots[0];
+				break;
+			case 'u':
+				umbral = atof(optarg);
+				break;
+			case 'a':
+				alfa = atof(optarg);
+				break;
+			case 'h':
+				holgura = atof(optarg);
+				break;
+			default:
+				nucMot = motIni;
+				return(usoSoak());
+			}
+		}
+	if(dur <= 0 || intervalo <= 0 || intervalo > dur)
+		{
+		nucMot = motIni;
+		return(usoSoak());
+		}
+
+	maxM = tam < n_8 ? 1 : (size_t)((tam + n_8 - 1) / n_8);
+	nInt = (size_t)ceil(dur / intervalo);
+	w = nInt / 4 > soakVent ? nInt / 4 : soakVent;
+	M	= malloc(maxM * sizeof(bloque));
+	C	= malloc(maxM * sizeof(bloque));
+	D	= malloc(maxM * sizeof(bloque));
+	lat	= malloc(soakMu * sizeof(double));
+	tasa	= malloc(nInt * sizeof(double));
+	p99	= malloc(nInt * sizeof(double));
+	rss	= malloc(nInt * sizeof(double));
+	heap	= malloc(nInt * sizeof(double));
+	if(M == NULL || C == NULL || D == NULL || lat == NULL || tasa == NULL || p99 == NULL || rss == NULL || heap == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+
+	printf("motor %s, %zu intervalos de %.0f s, mensajes de hasta %zu bloques\n", nomMot[nucMot], nInt, intervalo, maxM);
+	printf("%8s %10s %9s %9s %9s %9s (us) %10s %10s %7s\n", "t (s)", "ops/s", "MB/s", "p50", "p99", "p99.9", "RSS KiB", "heap KiB", "fallos");
+	for(k=0;k<nInt;k++)
+		{
+		ops = 0;
+		proc = 0;
+		fInt = 0;
+		nLat = 0;
+		tIni = metReloj();
+		while((tOp = metReloj()) - tIni < intervalo)
+			{
+			fInt += soakOp(&sem, maxM, M, C, D, &proc);
+			ahora = metReloj();
+			// Reservoir sample: every operation of the interval is equally likely to be kept
+			j = (nLat < soakMu) ? nLat++ : (size_t)(aleat(&sem) % (ops + 1));
+			if(j < soakMu)
+				{
+				lat[j] = ahora - tOp;
+				}
+			ops++;
+			}
+		el = metReloj() - tIni;
+		qsort(lat, nLat, sizeof(double), cmpDoble);
+		tasa[k]	= ops / el;
+		p99[k]	= percentil(lat, nLat, 0.99);
+		rss[k]	= (double)memRSS();
+		heap[k]	= (double)memHeap();
+		opsTot += ops;
+		fallos += fInt;
+
+		if(k == w)
+			{
+			// Reference window complete (intervals 1 to w)
+			memcpy(lat, tasa + 1, w * sizeof(double));
+			qsort(lat, w, sizeof(double), cmpDoble);
+			baseTasa = percentil(lat, w, 0.5);
+			for(j=1;j<=w;j++)
+				{
+				baseRSS = rss[j] > baseRSS ? rss[j] : baseRSS;
+				baseHeap = heap[j] > baseHeap ? heap[j] : baseHeap;
+				}
+			}
+		printf("%8.0f %10.0f %9.2f %9.2f %9.2f %9.2f      %10.0f %10.0f %7" PRIu64 "%s\n",
+			(k + 1) * intervalo, tasa[k], proc / el / 1e6, percentil(lat, nLat, 0.5) * 1e6, p99[k] * 1e6,
+			percentil(lat, nLat, 0.999) * 1e6, rss[k], heap[k], fInt,
+			(k > w && (tasa[k] < baseTasa * (1 - umbral / 100) || rss[k] > baseRSS + holgura || heap[k] > baseHeap + holgura)) ? "  !" : "");
+		fflush(stdout);
+		}
+	nucMot = motIni;
+
+	printf("\n%" PRIu64 " operaciones, %" PRIu64 " fallos\n", opsTot, fallos);
+	if(nInt < 2 * w + 1)
+		{
+		printf("Muy pocos intervalos para evaluar la deriva (minimo %zu)\n", 2 * w + 1);
+		}
+	else
+		{
+		pv = mannWhitney(tasa + nInt - w, w, tasa + 1, w);
+		est = razonHL(tasa + nInt - w, w, tasa + 1, w, &inf, &sup);
+		printf("ops/s final/referencia: %.4f [%.4f, %.4f] p=%.2g, pendiente %+.2f %%/h\n", est, inf, sup, pv,
+			baseTasa > 0 ? pendiente(tasa + 1, nInt - 1) * 3600 / intervalo / baseTasa * 100 : 0);
+		if(pv < alfa && est < 1 - umbral / 100)
+			{
+			printf("  DERIVA: el rendimiento cayo mas de %.1f%%\n", umbral);
+			deriva = 1;
+			}
+		pv = mannWhitney(p99 + nInt - w, w, p99 + 1, w);
+		est = razonHL(p99 + nInt - w, w, p99 + 1, w, &inf, &sup);
+		printf("p99 final/referencia:   %.4f [%.4f, %.4f] p=%.2g\n", est, inf, sup, pv);
+		if(pv < alfa && est > 1 + umbral / 100)
+			{
+			printf("  DERIVA: el p99 crecio mas de %.1f%%\n", umbral);
+			deriva = 1;
+			}
+		printf("RSS:  %+.0f KiB sobre la referencia, pendiente %+.1f KiB/h\n", rss[nInt-1] - baseRSS,
+			pendiente(rss + 1, nInt - 1) * 3600 / intervalo);
+		printf("heap: %+.0f KiB sobre la referencia, pendiente %+.1f KiB/h\n", heap[nInt-1] - baseHeap,
+			pendiente(heap + 1, nInt - 1) * 3600 / intervalo);
+		if(rss[nInt-1] > baseRSS + holgura || heap[nInt-1] > baseHeap + holgura)
+			{
+			printf("  DERIVA: la memoria crecio mas de %.0f KiB\n", holgura);
+			deriva = 1;
+			}
+		}
+
+	free(M);
+	free(C);
+	free(D);
+	free(lat);
+	free(tasa);
+	free(p99);
+	free(rss);
+	free(heap);
+	return(fallos != 0 ? 3 : (deriva ? 2 : 0));
+	}
+
+/*
+ * Function: eneHilo()
+ *
+ * Purpose: Worker of bench energia: encrypts messages until its deadline
+ *
+ * Parameters:
+ *   - void *p: eneTrab of this thread (ops is written back)
+ *
+ * Returns: NULL
+ */
+static void * eneHilo(void *p)
+	{
+	eneTrab *W = (eneTrab *)p;
+	bloque sem = semBanco ^ (bloque)(uintptr_t)p;
+	bloque K[2];
+	bloque A[1];
+	bloques M = malloc(W->m * sizeof(bloque));
+	bloques C = malloc(W->m * sizeof(bloque));
+	llaveExp L;
+	llaveLote XL;
+	uint64_t i;
+
+	if(M == NULL || C == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	K[0] = aleat(&sem);
+	K[1] = aleat(&sem);
+	A[0] = aleat(&sem);
+	for(i=0;i<W->m;i++)
+		{
+		M[i] = aleat(&sem);
+		}
+	expandeLlave(&L, K);
+	desempacaLote(&XL, &L);
+
+	for(i=0; metReloj() < W->fin; i++)
+		{
+		if(W->lote != 0)
+			{
+			midoriLote(&XL, M, W->m, C);
+			}
+		else
+			{
+			COFBbuf(K, i, A, 1, M, W->m, C);
+			}
+		}
+	W->ops = i;
+	free(M);
+	free(C);
+	return(NULL);
+	}
+
+/*
+ * Function: usoEnergia()
+ *
+ * Purpose: Prints the usage of the energy mode
+ */
+static int usoEnergia()
+	{
+	fprintf(stderr,"Uso: cifrador bench energia [-t segundos] [-s bytes,...] [-e motor,...] [-j hilos,...]\n");
+	fprintf(stderr,"       [--rapl DIR]\n");
+	return(1);
+	}
+
+/*
+ * Function: bancoEnergia()
+ *
+ * Purpose: Energy per byte and per message of every engine and thread
+ *          count, from the RAPL counters
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "energia")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -t SECONDS:    Duration of each run (default 2)
+ *   - -s BYTES,...:  Message sizes (default 64,4096)
+ *   - -e ENGINE,...: COFB engines (nomMot) and batch kernels (nomLote);
+ *                    default every one this CPU supports; unknown,
+ *                    repeated or unsupported labels are rejected
+ *   - -j THREADS,...: Thread counts, at most eneHilos (default 1 and the
+ *                    online CPUs, capped at eneHilos)
+ *   - --rapl DIR:    powercap directory (default eneRaiz)
+ *
+ * Returns:
+ *   - int: 0 on success or when RAPL is unavailable (the run is
+ *          skipped), 1 on usage errors
+ *
+ * Rows per (engine, threads, size):
+ *   - COFB engines run COFBbuf() with one AD block, batch kernels run
+ *     midoriLote() on the message blocks as independent blocks
+ *   - The counters are sampled right before the threads start and right
+ *     after they are joined; J/GB and uJ/msg are gross package (and
+ *     core, when exposed) energy, so they include the idle power shown
+ *     in the header, which is sampled first over one run length
+ */
+int bancoEnergia(int argc, char *argv[])
+	{
+	static struct option largas[] = {
+		{"rapl",	required_argument, NULL, 'r'},
+		{NULL, 0, NULL, 0}
+		};
+	uint64_t tams[maxPr] = {64, 4096};
+	size_t hils[maxPr] = {1, 0};
+	size_t nTam = 2;
+	size_t nHil = 2;
+	size_t nEng = 0;
+	size_t c;
+	size_t e;
+	size_t h;
+	size_t w;
+	size_t i;
+	size_t l;
+	uint64_t ops;
+	uint64_t e0[eneZonas];
+	uint64_t e1[eneZonas];
+	double dur = 2;
+	double J[eneDoms];
+	double el;
+	double t0;
+	double gb;
+	cad raiz = eneRaiz;
+	char *q;
+	char *s;
+	int opc;
+	byte engs[nMot + nLote];
+	byte motIni = nucMot;
+	byte loteIni = loteMot;
+	rapl R;
+	eneTrab W[eneHilos];
+	pthread_t hilo[eneHilos];
+
+	hils[1] = (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+	hils[1] = hils[1] > eneHilos ? eneHilos : hils[1];
+	nHil = hils[1] > 1 ? 2 : 1;
+	optind = 1;
+	while((opc = getopt_long(argc, argv, "t:s:e:j:", largas, NULL)) != -1)
+		{
+		switch(opc)
+			{
+			case 't':
+				dur = atof(optarg);
+				break;
+			case 's':
+				nTam = 0;
+				for(q=optarg; *q != 0 && nTam < maxPr; q += (*q == ','))
+					{
+					tams[nTam++] = strtoull(q, &q, 10);
+					}
+				break;
+			case 'j':
+				nHil = 0;
+				for(q=optarg; *q != 0 && nHil < maxPr; q += (*q == ','))
+					{
+					hils[nHil] = strtoull(q, &q, 10);
+					if(hils[nHil] == 0 || hils[nHil] > eneHilos)
+						{
+						return(usoEnergia());
+						}
+					nHil++;
+					}
+				break;
+			case 'e':
+				// Labels of both lists: engine e < nMot is nomMot[e], else nomLote[e - nMot]
+				for(s=optarg; *s != 0; s += l + (s[l] == ','))
+					{
+					l = strcspn(s, ",");
+					for(e=0; e<nMot+nLote; e++)
+						{
+						q = (char *)(e < nMot ? nomMot[e] : nomLote[e - nMot]);
+						if(strlen(q) == l && strncmp(s, q, l) == 0)
+							{
+							break;
+							}
+						}
+					for(w=0; w<nEng && engs[w] != e; w++);
+					if(e == nMot + nLote || w < nEng || (e < nMot ? hayMot((byte)e) : hayLote((byte)(e - nMot))) == 0)
+						{
+						return(usoEnergia());
+						}
+					engs[nEng++] = (byte)e;
+					}
+				break;
+			case 'r':
+				raiz = optarg;
+				break;
+			default:
+				return(usoEnergia());
+			}
+		}
+	if(dur <= 0 || nTam == 0 || nHil == 0)
+		{
+		return(usoEnergia());
+		}
+	if(nEng == 0)
+		{
+		for(e=0;e<nMot+nLote;e++)
+			{
+			if((e < nMot ? hayMot((byte)e) : hayLote((byte)(e - nMot))) != 0)
+				{
+				engs[nEng++] = (byte)e;
+				}
+			}
+		}
+
+	if(raplAbre(&R, raiz) != 0 || raplLee(&R, e0) != 0)
+		{
+		printf("RAPL no disponible en %s (sin zonas package legibles): se omite la medicion de energia\n", raiz);
+		return(0);
+		}
+
+	// Idle power over one run length
+	t0 = metReloj();
+	usleep((useconds_t)(dur * 1e6));
+	raplLee(&R, e1);
+	el = metReloj() - t0;
+	raplJulios(&R, e0, e1, J);
+	printf("RAPL: %zu zonas en %s, reposo %.2f W paquete", R.t, raiz, J[enePaq] / el);
+	if(R.hay[eneNuc] != 0)
+		{
+		printf(", %.2f W nucleos", J[eneNuc] / el);
+		}
+	printf("\n%-6s %-5s %5s %8s %10s %8s %10s %12s %12s\n", "motor", "tipo", "hilos", "bytes", "MB/s", "W paq", "J/GB paq", "uJ/msg paq", "J/GB nucleo");
+
+	for(c=0;c<nEng*nHil*nTam;c++)
+		{
+		e = engs[c / (nHil * nTam)];
+		h = hils[(c / nTam) % nHil];
+		i = c % nTam;
+		if(e < nMot)
+			{
+			nucMot = (byte)e;
+			}
+		else
+			{
+			loteMot = (byte)(e - nMot);
+			}
+
+		raplLee(&R, e0);
+		t0 = metReloj();
+		for(w=0;w<h;w++)
+			{
+			W[w].lote = e >= nMot;
+			W[w].m = tams[i] < n_8 ? 1 : (tams[i] + n_8 - 1) / n_8;
+			W[w].fin = t0 + dur;
+			W[w].ops = 0;
+			if(pthread_create(&hilo[w], NULL, eneHilo, &W[w]) != 0)
+				{
+				fprintf(stderr,"Error al crear hilos\n");
+				exit(1);
+				}
+			}
+		for(ops=0, w=0; w<h; w++)
+			{
+			pthread_join(hilo[w], NULL);
+			ops += W[w].ops;
+			}
+		el = metReloj() - t0;
+		raplLee(&R, e1);
+		raplJulios(&R, e0, e1, J);
+
+		gb = ops * W[0].m * n_8 / 1e9;
+		printf("%-6s %-5s %5zu %8" PRIu64 " %10.2f %8.2f %10.2f %12.3f", e < nMot ? nomMot[e] : nomLote[e - nMot],
+			e < nMot ? "cofb" : "lote", h, W[0].m * n_8, gb * 1e3 / el, J[enePaq] / el,
+			gb > 0 ? J[enePaq] / gb : 0, ops > 0 ? J[enePaq] / ops * 1e6 : 0);
+		if(R.hay[eneNuc] != 0)
+			{
+			printf(" %12.2f\n", gb > 0 ? J[eneNuc] / gb : 0);
+			}
+		else
+			{
+			printf(" %12s\n", "-");
+			}
+		fflush(stdout);
+		}
+	nucMot = motIni;
+	loteMot = loteIni;
+	return(0);
+	}
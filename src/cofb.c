@@ -22,6 +22,12 @@
  *   - Tripling (multiply by 3): double + add in GF
  *   - General operations: table-based mask generation
  * 
+ * Specialized Shapes:
+ *   For 1-2 associated data blocks with 2, 4, 8 or 16 message blocks, the
+ *   block counts are compile-time constants: the mask ladder, the final
+ *   block test and the chain loop are resolved and unrolled per shape.
+ *   COFBbuf() and dCOFBbuf() route matching sizes there (cofbCorto()).
+ * 
  * Author: COFB-Midori64 Project
  * Date: December 2025
  * ============================================================================
@@ -29,6 +35,12 @@
 
 #include"cofb.h"
 
+/*
+ * cofbEsp: 1 while COFBbuf() and dCOFBbuf() route the fixed shapes to
+ *          cofbCorto() (benchmarks clear it to time the generic path)
+ */
+byte cofbEsp = 1;
+
 /*
  * Function: COFB()
  * 
@@ -77,6 +89,9 @@ bloque COFB(bloques K, bloque N)
 	bloque X;					// Input to cipher
 	bloque C;					// Ciphertext block
 	bloque T;					// Authentication tag
+	uint64_t blqA = 0;			// Associated data blocks processed
+	uint64_t blqM = 0;			// Message blocks processed
+	double t0 = metReloj();		// Operation start time
 
 	// Initialize from nonce
 	Y = midori(N,K,0);
@@ -130,7 +145,14 @@ bloque COFB(bloques K, bloque N)
 			{
 			C = Y ^ B;
 			printf("%016llx",C);
+			blqM++;
 			}
+		else
+			{
+			blqA++;
+			}
+		// Fold input block into the capture payload hash
+		trzAcum(B);
 
 		// Apply cipher to produce next state
 		Y = midori(X,K,0);
@@ -154,6 +176,7 @@ bloque COFB(bloques K, bloque N)
 	// Final tag is final state
 	T = Y;
 	
+	metOp(opCif, t0, blqA, blqM);
 	return(T);
 	}
 
@@ -198,6 +221,9 @@ bloque dCOFB(bloques K, bloque N, bloque T)
 	bloque X;					// Input to cipher
 	bloque C;					// Ciphertext block
 	bloque T_;					// Computed authentication tag
+	uint64_t blqA = 0;			// Associated data blocks processed
+	uint64_t blqM = 0;			// Message blocks processed
+	double t0 = metReloj();		// Operation start time
 
 	// Initialize from nonce (same as encryption)
 	Y = midori(N,K,0);
@@ -244,7 +270,14 @@ bloque dCOFB(bloques K, bloque N, bloque T)
 			BGY = Y ^ BGY;		// Reverse the XOR
 			C = Y ^ B;			// Recover plaintext
 			printf("%016llx",C);
-			}		
+			blqM++;
+			}
+		else
+			{
+			blqA++;
+			}
+		// Fold input block into the capture payload hash
+		trzAcum(B);
 		
 		// Combine mask and BGY for next state
 		X = (msk << 32) ^ BGY;		
@@ -271,9 +304,472 @@ bloque dCOFB(bloques K, bloque N, bloque T)
 	// Computed tag
 	T_ = Y;
 
+	// Count tags that do not match the received one
+	if(T_ != T)
+		{
+		metFalla();
+		}
+	metOp(opDes, t0, blqA, blqM);
 	return(T_);
 	}
 
+/*
+ * Function: COFBini()
+ * 
+ * Purpose: Starts an incremental encryption or decryption
+ * 
+ * Parameters:
+ *   - cofbEdo *E: Operation state (output)
+ *   - byte op: opCif or opDes
+ *   - bloques K: 128-bit encryption key (array of 2 blocks)
+ *   - bloque N: 64-bit nonce
+ *   - bloques A: Associated data blocks (at least one)
+ *   - size_t a: Number of associated data blocks
+ * 
+ * Returns: void
+ * 
+ * Details: The key is expanded once per operation instead of once per
+ *          block as in COFB()
+ */
+void COFBini(cofbEdo *E, byte op, bloques K, bloque N, bloques A, size_t a)
+	{
+	llaveExp L;
+
+	expandeLlave(&L, K);
+	COFBiniExp(E, op, &L, N, A, a);
+	return;
+	}
+
+/*
+ * Function: cifraY()
+ * 
+ * Purpose: Runs one Midori call of the chain with the operation's engine
+ * 
+ * Parameters:
+ *   - cofbEdo *E: Operation state
+ *   - bloque S: Cipher input
+ * 
+ * Returns:
+ *   - bloque: Cipher output
+ */
+static inline bloque cifraY(cofbEdo *E, bloque S)
+	{
+	return((E->mot == motNib) ? midoriNib(S,&E->X) : midoriExp(S,&E->L,0));
+	}
+
+/*
+ * Function: COFBiniExp()
+ * 
+ * Purpose: Starts an incremental operation with an expanded key
+ * 
+ * Parameters:
+ *   - cofbEdo *E: Operation state (output)
+ *   - byte op: opCif or opDes
+ *   - llaveExp *L: Key expanded by expandeLlave() or loaded from a key
+ *                  store (copied into E)
+ *   - bloque N: 64-bit nonce
+ *   - bloques A: Associated data blocks (at least one)
+ *   - size_t a: Number of associated data blocks
+ * 
+ * Returns: void
+ * 
+ * Details: The associated data is absorbed entirely here; the message
+ *          then flows through any number of COFBsig() calls
+ */
+void COFBiniExp(cofbEdo *E, byte op, llaveExp *L, bloque N, bloques A, size_t a)
+	{
+	size_t i;
+	bloque msk;					// Block-specific mask
+
+	E->t0	= metReloj();
+	E->L	= *L;
+	E->op	= op;
+	E->mot	= nucMot;
+	E->hay	= 0;
+	E->a	= a;
+	E->m	= 0;
+
+	if(E->mot == motNib)
+		{
+		desempacaLlave(&E->X, &E->L);
+		}
+
+	E->Y	= cifraY(E, N);
+	E->mx	= maskGen(E->Y);
+
+	// Associated data: doubling for all but the last block
+	for(i=0;i<a;i++)
+		{
+		msk = (i+1 < a) ? (E->mx = gdoble(E->mx)) : gtriple(E->mx);
+		E->Y = cifraY(E, (msk << 32) ^ A[i] ^ mulGY(E->Y));
+		}
+	return;
+	}
+
+/*
+ * Function: encadena()
+ * 
+ * Purpose: Folds the pending plaintext block into the cipher state
+ * 
+ * Parameters:
+ *   - cofbEdo *E: Operation state holding a pending block
+ *   - byte fin: 1 if the pending block is the last of the message
+ * 
+ * Returns: void
+ */
+static void encadena(cofbEdo *E, byte fin)
+	{
+	bloque msk;					// Block-specific mask
+
+	if(fin == 0)
+		{
+		E->mx = gdoble(E->mx);
+		msk = gtriple(E->mx);
+		}
+	else
+		{
+		msk = gtriple(gtriple(E->mx));
+		}
+	E->Y = cifraY(E, (msk << 32) ^ E->pend ^ mulGY(E->Y));
+	return;
+	}
+
+/*
+ * Function: COFBsig()
+ * 
+ * Purpose: Encrypts or decrypts the next message blocks of an operation
+ * 
+ * Parameters:
+ *   - cofbEdo *E: State started with COFBini()
+ *   - bloques X: Input blocks (plaintext or ciphertext)
+ *   - size_t m: Number of blocks
+ *   - bloques Z: Output blocks (m blocks, may alias X)
+ * 
+ * Returns: void
+ * 
+ * Details:
+ *   - Output block i only depends on the state left by block i-1, so
+ *     every block is emitted immediately
+ *   - Only the mask of the last block differs, hence the most recent
+ *     plaintext block stays pending until the next call or COFBfin()
+ *     says whether it was final
+ */
+void COFBsig(cofbEdo *E, bloques X, size_t m, bloques Z)
+	{
+	size_t i;
+	bloque B;					// Current input block
+
+	for(i=0;i<m;i++)
+		{
+		if(E->hay != 0)
+			{
+			encadena(E, 0);
+			}
+		B = X[i];
+		Z[i] = E->Y ^ B;
+		E->pend = (E->op == opCif) ? B : Z[i];
+		E->hay = 1;
+		}
+	E->m += m;
+	return;
+	}
+
+/*
+ * Function: COFBtrans()
+ * 
+ * Purpose: Re-encrypts ciphertext blocks under a second key in one pass
+ * 
+ * Parameters:
+ *   - cofbEdo *D: Decryption state under the old key (opDes)
+ *   - cofbEdo *E: Encryption state under the new key (opCif)
+ *   - bloques X: Ciphertext blocks under the old key
+ *   - size_t m: Number of blocks
+ *   - bloques Z: Ciphertext blocks under the new key (may alias X)
+ * 
+ * Returns: void
+ * 
+ * Details:
+ *   - Equivalent to COFBsig(D) followed by COFBsig(E), but each
+ *     plaintext block goes straight from one chain into the other and
+ *     is never stored, so the data is read and written once
+ *   - The two cipher calls per block are independent of each other
+ *   - D and E must have processed the same number of message blocks;
+ *     the output may only be kept once COFBfin(D, T) confirms the old
+ *     tag
+ */
+void COFBtrans(cofbEdo *D, cofbEdo *E, bloques X, size_t m, bloques Z)
+	{
+	size_t i;
+	bloque P;					// Plaintext block (transient)
+
+	for(i=0;i<m;i++)
+		{
+		if(D->hay != 0)
+			{
+			encadena(D, 0);
+			encadena(E, 0);
+			}
+		P = D->Y ^ X[i];
+		Z[i] = E->Y ^ P;
+		D->pend	= P;
+		E->pend	= P;
+		D->hay	= 1;
+		E->hay	= 1;
+		}
+	D->m += m;
+	E->m += m;
+	return;
+	}
+
+/*
+ * Function: COFBfin()
+ * 
+ * Purpose: Completes an incremental operation
+ * 
+ * Parameters:
+ *   - cofbEdo *E: State started with COFBini()
+ *   - bloque T: Received tag (ignored when encrypting)
+ * 
+ * Returns:
+ *   - bloque: Authentication tag (equal to T when a decryption is valid)
+ */
+bloque COFBfin(cofbEdo *E, bloque T)
+	{
+	if(E->hay != 0)
+		{
+		encadena(E, 1);
+		E->hay = 0;
+		}
+	if(E->op == opDes && E->Y != T)
+		{
+		metFalla();
+		}
+	metOp(E->op, E->t0, E->a, E->m);
+	return(E->Y);
+	}
+
+/*
+ * Function: cofbFijoMot()
+ * 
+ * Purpose: Body of the specialized kernels for one shape and one engine
+ * 
+ * Parameters:
+ *   - byte op: opCif or opDes
+ *   - byte mot: motRef or motNib
+ *   - llaveExp *L, llaveNib *X: Expanded key (X only with motNib)
+ *   - bloque N: 64-bit nonce
+ *   - bloques A: Associated data blocks (a blocks)
+ *   - size_t a, size_t m: Block counts, constants at every call site
+ *   - bloques I: Input blocks (m blocks)
+ *   - bloques O: Output blocks (m blocks, may alias I)
+ * 
+ * Returns:
+ *   - bloque: Tag
+ * 
+ * Details: Always inlined, so op, mot, a and m are constants: the final
+ *          block tests fold away, the loops unroll and the mask of every
+ *          block reduces to its fixed doubling/tripling sequence. Same
+ *          chain and masks as COFBiniExp(), COFBsig() and COFBfin()
+ */
+static inline __attribute__((always_inline)) bloque cofbFijoMot(byte op, byte mot, llaveExp *L, llaveNib *X, bloque N, bloques A, size_t a, bloques I, size_t m, bloques O)
+	{
+	size_t i;
+	bloque Y;
+	bloque B;					// Current input block
+	bloque P;					// Plaintext block
+	bloque msk;					// Block-specific mask
+	tn2 mx;
+
+	Y = (mot == motNib) ? midoriNib(N, X) : midoriExp(N, L, 0);
+	mx = maskGen(Y);
+
+#pragma GCC unroll 16
+	for(i=0;i<a;i++)
+		{
+		msk = (i+1 < a) ? (mx = gdoble(mx)) : gtriple(mx);
+		B = (msk << 32) ^ A[i] ^ mulGY(Y);
+		Y = (mot == motNib) ? midoriNib(B, X) : midoriExp(B, L, 0);
+		}
+
+#pragma GCC unroll 16
+	for(i=0;i<m;i++)
+		{
+		B = I[i];
+		O[i] = Y ^ B;
+		P = (op == opCif) ? B : O[i];
+		if(i+1 < m)
+			{
+			mx = gdoble(mx);
+			msk = gtriple(mx);
+			}
+		else
+			{
+			msk = gtriple(gtriple(mx));
+			}
+		B = (msk << 32) ^ P ^ mulGY(Y);
+		Y = (mot == motNib) ? midoriNib(B, X) : midoriExp(B, L, 0);
+		}
+	return(Y);
+	}
+
+/*
+ * Function: cofbFijo()
+ * 
+ * Purpose: Fixed-shape kernel for cofbCorto() (key, engine, metrics)
+ * 
+ * Parameters:
+ *   - byte op: opCif or opDes
+ *   - bloques K: 128-bit encryption key
+ *   - bloque N, bloques A, size_t a, bloques I, size_t m, bloques O:
+ *     As in cofbFijoMot()
+ *   - bloque T: Received tag (ignored when encrypting)
+ * 
+ * Returns:
+ *   - bloque: Tag (equal to T when a decryption is valid)
+ * 
+ * Details: One copy of the chain per engine, so the engine test runs
+ *          once per message instead of once per block
+ */
+static inline __attribute__((always_inline)) bloque cofbFijo(byte op, bloques K, bloque N, bloques A, size_t a, bloques I, size_t m, bloques O, bloque T)
+	{
+	double t0 = metReloj();
+	llaveExp L;
+	llaveNib X;
+	bloque Y;
+
+	expandeLlave(&L, K);
+	if(nucMot == motNib)
+		{
+		desempacaLlave(&X, &L);
+		Y = cofbFijoMot(op, motNib, &L, &X, N, A, a, I, m, O);
+		}
+	else
+		{
+		Y = cofbFijoMot(op, motRef, &L, &X, N, A, a, I, m, O);
+		}
+	if(op == opDes && Y != T)
+		{
+		metFalla();
+		}
+	metOp(op, t0, a, m);
+	return(Y);
+	}
+
+/*
+ * Function: cofbCorto()
+ * 
+ * Purpose: Shared body of COFBbuf() and dCOFBbuf(): fixed shapes go to
+ *          cofbFijo() with constant block counts, the rest to the
+ *          incremental API
+ * 
+ * Parameters:
+ *   - byte op: opCif or opDes
+ *   - bloques K, bloque N, bloques A, size_t a, bloques I, size_t m,
+ *     bloques O: As in cofbFijo()
+ *   - bloque T: Received tag (0 when encrypting)
+ * 
+ * Returns:
+ *   - bloque: Tag (equal to T when a decryption is valid)
+ */
+static bloque cofbCorto(byte op, bloques K, bloque N, bloques A, size_t a, bloques I, size_t m, bloques O, bloque T)
+	{
+	cofbEdo E;
+
+	switch((cofbEsp != 0 && a <= 2 && m <= 16) ? (a << 5 | m) : 0)
+		{
+		case 1 << 5 | 2:	return(cofbFijo(op, K, N, A, 1, I, 2, O, T));
+		case 1 << 5 | 4:	return(cofbFijo(op, K, N, A, 1, I, 4, O, T));
+		case 1 << 5 | 8:	return(cofbFijo(op, K, N, A, 1, I, 8, O, T));
+		case 1 << 5 | 16:	return(cofbFijo(op, K, N, A, 1, I, 16, O, T));
+		case 2 << 5 | 2:	return(cofbFijo(op, K, N, A, 2, I, 2, O, T));
+		case 2 << 5 | 4:	return(cofbFijo(op, K, N, A, 2, I, 4, O, T));
+		case 2 << 5 | 8:	return(cofbFijo(op, K, N, A, 2, I, 8, O, T));
+		case 2 << 5 | 16:	return(cofbFijo(op, K, N, A, 2, I, 16, O, T));
+		}
+	COFBini(&E, op, K, N, A, a);
+	COFBsig(&E, I, m, O);
+	return(COFBfin(&E, T));
+	}
+
+/*
+ * Function: COFBbuf()
+ * 
+ * Purpose: Encrypts a message held in memory and generates its tag
+ * 
+ * Parameters:
+ *   - bloques K: 128-bit encryption key (array of 2 blocks)
+ *   - bloque N: 64-bit nonce
+ *   - bloques A: Associated data blocks (at least one)
+ *   - size_t a: Number of associated data blocks
+ *   - bloques M: Plaintext blocks (at least one)
+ *   - size_t m: Number of plaintext blocks
+ *   - bloques C: Output ciphertext blocks (m blocks, may alias M)
+ * 
+ * Returns:
+ *   - bloque: Authentication tag T
+ * 
+ * Details:
+ *   - Produces the same ciphertext and tag as COFB() for the same
+ *     key, nonce and blocks read from stdin
+ *   - The Galois field ladder of goper() is kept in the operation state
+ *     instead of the static mx2, so calls are reentrant
+ *   - Mask sequence: 2^i*β for non-final AD blocks, 3*mx for the final
+ *     AD block, 3*(2*mx) for non-final message blocks and 9*mx for the
+ *     final message block
+ */
+bloque COFBbuf(bloques K, bloque N, bloques A, size_t a, bloques M, size_t m, bloques C)
+	{
+	return(cofbCorto(opCif, K, N, A, a, M, m, C, 0));
+	}
+
+/*
+ * Function: dCOFBbuf()
+ * 
+ * Purpose: Decrypts a message held in memory and verifies its tag
+ * 
+ * Parameters:
+ *   - bloques K: 128-bit encryption key
+ *   - bloque N: 64-bit nonce
+ *   - bloques A: Associated data blocks (at least one)
+ *   - size_t a: Number of associated data blocks
+ *   - bloques C: Ciphertext blocks (at least one)
+ *   - size_t m: Number of ciphertext blocks
+ *   - bloques M: Output plaintext blocks (m blocks, may alias C)
+ *   - bloque T: Received authentication tag
+ * 
+ * Returns:
+ *   - bloque: Computed authentication tag T_ (equal to T when valid)
+ * 
+ * Details: Mirrors COFBbuf(); the plaintext recovered from each block
+ *          feeds the chain exactly as in dCOFB()
+ */
+bloque dCOFBbuf(bloques K, bloque N, bloques A, size_t a, bloques C, size_t m, bloques M, bloque T)
+	{
+	return(cofbCorto(opDes, K, N, A, a, C, m, M, T));
+	}
+
+/*
+ * Function: vCOFBbuf()
+ * 
+ * Purpose: Decrypts a message held in memory and releases it only if its
+ *          tag verifies
+ * 
+ * Parameters: Same as dCOFBbuf()
+ * 
+ * Returns:
+ *   - 0: Tag verified, M holds the plaintext
+ *   - 1: Authentication failure, M has been zeroed
+ */
+byte vCOFBbuf(bloques K, bloque N, bloques A, size_t a, bloques C, size_t m, bloques M, bloque T)
+	{
+	if(dCOFBbuf(K, N, A, a, C, m, M, T) != T)
+		{
+		memset(M, 0, m * sizeof(bloque));
+		return(1);
+		}
+	return(0);
+	}
+
 /*****************************************************************************
  * GALOIS FIELD ARITHMETIC OPERATIONS
  * 
@@ -607,11 +1103,22 @@ void impVect(vect A)
 	
 	}
 
+/*
+ * Function: genVect()
+ * 
+ * Purpose: Allocates a zeroed byte vector
+ * 
+ * Parameters:
+ *   - byte t: Length in bytes
+ * 
+ * Returns:
+ *   - vect: New vector, owned by the caller (release with libVect())
+ */
 vect genVect(byte t)
 	{
 	vect unVect;
 	
-	unVect	= (vect)malloc(sizeof(vect));
+	unVect	= (vect)malloc(sizeof(*unVect));
 	
 	if(unVect==NULL)
 		{
@@ -629,37 +1136,81 @@ vect genVect(byte t)
 	return(unVect);
 	}
 
+/*
+ * Function: libVect()
+ * 
+ * Purpose: Releases a vector from genVect() or cadToVect()
+ * 
+ * Parameters:
+ *   - vect A: Vector (NULL is ignored)
+ */
+void libVect(vect A)
+	{
+	if(A != NULL)
+		{
+		free(A->v);
+		free(A);
+		}
+	return;
+	}
+
+/*
+ * Function: leerEnt()
+ * 
+ * Purpose: Reads a hex string from stdin
+ * 
+ * Returns:
+ *   - cad: The hex digits up to the first other character, NUL-terminated
+ *          and owned by the caller (release with free())
+ * 
+ * Details: The character that ends the string is consumed; the end of
+ *          input also ends it
+ */
 cad leerEnt()
 	{
-	char car;
-	char tmp[n_4 + 1] = {};
-	int l = 0;
-	int t = n_4;
-	byte ban;
+	int car;
+	size_t l = 0;
+	size_t t = n_8;
 	cad A = malloc(t * sizeof(char));
 	cad B;
 
-	do
+	if(A == NULL)
 		{
-		
-		if((l & n4m) == 0)
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	while((car = getchar()) != EOF && esHex((char)car) == 0)
+		{
+		// Room for this character and the terminator
+		if(l + 2 > t)
 			{
-			t = t+l+1;
-			A = realloc(A,t * sizeof(char));
+			t <<= 1;
+			if((B = realloc(A, t * sizeof(char))) == NULL)
+				{
+				free(A);
+				fprintf(stderr,"Error al asignar memoria\n");
+				exit(1);
+				}
+			A = B;
 			}
-
-		scanf("%c",&car);
-		ban = esHex(car);
-		A[l] = ban==0 ? car : 0;
-		A[l+1] = 0;
-		
-		l++;
+		A[l++] = (char)car;
 		}
-	while(ban==0);
+	A[l] = 0;
 
 	return(A);
 	}
 
+/*
+ * Function: cadToVect()
+ * 
+ * Purpose: Parses a hex string into a byte vector
+ * 
+ * Parameters:
+ *   - cad A: Hex digits, two per byte (not released here)
+ * 
+ * Returns:
+ *   - vect: New vector, owned by the caller (release with libVect())
+ */
 vect cadToVect(cad A)
 	{
 	int t = (strlen(A)+1)>>1;
@@ -0,0 +1,377 @@
+/*
+ * ============================================================================
+ * File: contenedor.c
+ * Purpose: Segmented container format for encrypted files
+ *
+ * One COFB chain over a whole file forces sequential processing and a
+ * full re-encryption for any change. The container splits the plaintext
+ * into fixed-size segments, each an independent COFB operation with its
+ * own nonce and tag, so segments can be processed in parallel and
+ * rewritten individually.
+ *
+ * File Format (all integers big-endian):
+ *   Header (32 bytes):
+ *     "CFBC" | version (1) | flags (1) | reserved (2) |
+ *     segment size (4) | plaintext length (8) | base nonce (8) |
+ *     reserved (4)
+ *   Segment i, at 32 + i * (16 + segment size):
+ *     nonce (8) | tag (8) | ciphertext (segment length rounded up to 8)
+ *
+ * Segment Nonces:
+ *   - Bits 0-47: base nonce + segment index (a random 48-bit base)
+ *   - Bits 48-63: write counter of the segment, 0 when first written
+ *   Each record stores its nonce, so a rewritten segment can take the
+ *   next counter value without touching its neighbours. Segments added
+ *   by an update take a separately leased run of bases, so the header
+ *   base only describes the segments the container was created with.
+ *
+ * Associated Data (2 blocks per segment):
+ *   - A[0]: segment index
+ *   - A[1]: segment plaintext length, bit 63 set on the last segment
+ *   Reordered, truncated or extended containers fail verification.
+ *
+ * A partial last block is padded with 0x80 followed by zero bytes.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"contenedor.h"
+#include <sys/random.h>
+
+/*
+ * Function: ctnIni()
+ *
+ * Purpose: Describes a container for a plaintext of a given length
+ *
+ * Parameters:
+ *   - contenedor *C: Container description (output)
+ *   - uint32_t tSeg: Segment size in bytes (multiple of 8)
+ *   - uint64_t lon: Plaintext length in bytes
+ *   - bloque base: Nonce of segment 0, counter bits cleared
+ *
+ * Returns: void
+ *
+ * Details: An empty plaintext still has one (empty) segment, so its
+ *          tag authenticates the length
+ */
+void ctnIni(contenedor *C, uint32_t tSeg, uint64_t lon, bloque base)
+	{
+	C->tSeg	= tSeg;
+	C->lon	= lon;
+	C->base	= base & ctnBaseMsk;
+	C->nSeg	= lon / tSeg + (lon % tSeg != 0 || lon == 0);
+	return;
+	}
+
+/*
+ * Function: ctnPonCab()
+ *
+ * Purpose: Encodes the container header
+ *
+ * Parameters:
+ *   - contenedor *C: Container description
+ *   - bytes p: Destination (ctnCab bytes)
+ *
+ * Returns: void
+ */
+void ctnPonCab(contenedor *C, bytes p)
+	{
+	memset(p, 0, ctnCab);
+	memcpy(p, ctnMagia, 4);
+	p[4] = ctnVer;
+	p[8] = (byte)(C->tSeg >> 24);
+	p[9] = (byte)(C->tSeg >> 16);
+	p[10] = (byte)(C->tSeg >> 8);
+	p[11] = (byte)C->tSeg;
+	guardaBE(p + 12, C->lon);
+	guardaBE(p + 20, C->base);
+	return;
+	}
+
+/*
+ * Function: ctnLeeCab()
+ *
+ * Purpose: Decodes and validates a container header
+ *
+ * Parameters:
+ *   - bytes p: Header (ctnCab bytes)
+ *   - uint64_t tam: Size of the container file
+ *   - contenedor *C: Container description (output)
+ *
+ * Returns:
+ *   - 0: Valid header consistent with the file size
+ *   - 1: Not a container, unsupported version or wrong size (including
+ *        a length whose records would overflow or exceed tam)
+ */
+byte ctnLeeCab(bytes p, uint64_t tam, contenedor *C)
+	{
+	uint32_t tSeg;
+	uint64_t lon;
+	uint64_t nSeg;
+	bloque base;
+
+	if(memcmp(p, ctnMagia, 4) != 0 || p[4] != ctnVer)
+		{
+		return(1);
+		}
+	tSeg = ((uint32_t)p[8] << 24) | ((uint32_t)p[9] << 16) | ((uint32_t)p[10] << 8) | p[11];
+	lon = cargaBE(p + 12);
+	base = cargaBE(p + 20);
+	if(tSeg == 0 || tSeg % n_8 != 0 || tSeg > ctnSegMax)
+		{
+		return(1);
+		}
+
+	// lon is untrusted: every record must fit in the file before any
+	// offset derived from it is computed
+	nSeg = lon / tSeg + (lon % tSeg != 0 || lon == 0);
+	if(lon > tam || nSeg > (UINT64_MAX - ctnCab) / (ctnReg + tSeg)
+		|| ctnCab + (nSeg - 1) * (ctnReg + tSeg) + ctnReg > tam)
+		{
+		return(1);
+		}
+	ctnIni(C, tSeg, lon, base);
+	return(ctnTam(C) != tam);
+	}
+
+/*
+ * Function: ctnLonSeg()
+ *
+ * Purpose: Plaintext bytes held by a segment
+ */
+uint64_t ctnLonSeg(contenedor *C, uint64_t i)
+	{
+	return(i + 1 < C->nSeg ? C->tSeg : C->lon - i * C->tSeg);
+	}
+
+/*
+ * Function: ctnOff()
+ *
+ * Purpose: File offset of the record of a segment
+ */
+uint64_t ctnOff(contenedor *C, uint64_t i)
+	{
+	return(ctnCab + i * (ctnReg + (uint64_t)C->tSeg));
+	}
+
+/*
+ * Function: ctnTam()
+ *
+ * Purpose: Size in bytes of the whole container file
+ */
+uint64_t ctnTam(contenedor *C)
+	{
+	uint64_t l = ctnLonSeg(C, C->nSeg - 1);
+
+	return(ctnOff(C, C->nSeg - 1) + ctnReg + ((l + n_8 - 1) / n_8) * n_8);
+	}
+
+/*
+ * Function: ctnNonce()
+ *
+ * Purpose: Nonce of a segment for a given write counter
+ *
+ * Parameters:
+ *   - contenedor *C: Container description
+ *   - uint64_t i: Segment index
+ *   - uint64_t ctr: Write counter (0 for the first write)
+ *
+ * Returns:
+ *   - bloque: Counter in bits 48-63, base + i in bits 0-47
+ */
+bloque ctnNonce(contenedor *C, uint64_t i, uint64_t ctr)
+	{
+	return((ctr << ctnCtrDes) | ((C->base + i) & ctnBaseMsk));
+	}
+
+/*
+ * Function: ctnAD()
+ *
+ * Purpose: Associated data binding a segment to its position
+ */
+static void ctnAD(contenedor *C, uint64_t i, bloques A)
+	{
+	A[0] = i;
+	A[1] = ctnLonSeg(C, i) | ((bloque)(i + 1 == C->nSeg) << 63);
+	return;
+	}
+
+/*
+ * Function: ctnCifraSeg()
+ *
+ * Purpose: Encrypts one segment into its record
+ *
+ * Parameters:
+ *   - llaveExp *L: Expanded key
+ *   - contenedor *C: Container description
+ *   - uint64_t i: Segment index
+ *   - bloque N: Segment nonce (see ctnNonce())
+ *   - bytes e: Segment plaintext (ctnLonSeg() bytes)
+ *   - bytes reg: Record destination (nonce, tag and padded ciphertext)
+ *   - bloques B: Scratch blocks (tSeg / 8 blocks)
+ *
+ * Returns: void
+ */
+void ctnCifraSeg(llaveExp *L, contenedor *C, uint64_t i, bloque N, bytes e, bytes reg, bloques B)
+	{
+	uint64_t l = ctnLonSeg(C, i);
+	size_t m = (size_t)(l / n_8);
+	byte u[n_8];
+	bloque A[2];
+	bloque T;
+	cofbEdo E;
+
+	cargaBEs(e, B, m);
+	if(l % n_8 != 0)
+		{
+		// 10* padding of the partial last block
+		memset(u, 0, n_8);
+		memcpy(u, e + m * n_8, l % n_8);
+		u[l % n_8] = 0x80;
+		B[m++] = cargaBE(u);
+		}
+	ctnAD(C, i, A);
+	COFBiniExp(&E, opCif, L, N, A, 2);
+	COFBsig(&E, B, m, B);
+	T = COFBfin(&E, 0);
+
+	guardaBE(reg, N);
+	guardaBE(reg + n_8, T);
+	guardaBEs(B, reg + ctnReg, m);
+	return;
+	}
+
+/*
+ * Function: ctnDescifraSeg()
+ *
+ * Purpose: Decrypts and verifies one segment record
+ *
+ * Parameters:
+ *   - llaveExp *L: Expanded key
+ *   - contenedor *C: Container description
+ *   - uint64_t i: Segment index
+ *   - bytes reg: Record (nonce, tag and padded ciphertext)
+ *   - bytes s: Plaintext destination (ctnLonSeg() bytes)
+ *   - bloques B: Scratch blocks (tSeg / 8 blocks)
+ *
+ * Returns:
+ *   - 0: Tag and padding verified, s holds the plaintext
+ *   - 1: Authentication failure (s must be discarded)
+ */
+byte ctnDescifraSeg(llaveExp *L, contenedor *C, uint64_t i, bytes reg, bytes s, bloques B)
+	{
+	uint64_t l = ctnLonSeg(C, i);
+	size_t m = (size_t)((l + n_8 - 1) / n_8);
+	size_t j;
+	byte u[n_8];
+	bloque A[2];
+	bloque N;
+	bloque T;
+	cofbEdo E;
+
+	N = cargaBE(reg);
+	T = cargaBE(reg + n_8);
+	cargaBEs(reg + ctnReg, B, m);
+	ctnAD(C, i, A);
+	COFBiniExp(&E, opDes, L, N, A, 2);
+	COFBsig(&E, B, m, B);
+	if(COFBfin(&E, T) != T)
+		{
+		return(1);
+		}
+
+	guardaBEs(B, s, (size_t)(l / n_8));
+	if(l % n_8 != 0)
+		{
+		guardaBE(u, B[m-1]);
+		if(u[l % n_8] != 0x80)
+			{
+			return(1);
+			}
+		for(j=l%n_8+1;j<n_8;j++)
+			{
+			if(u[j] != 0)
+				{
+				return(1);
+				}
+			}
+		memcpy(s + (m - 1) * n_8, u, l % n_8);
+		}
+	return(0);
+	}
+
+/*
+ * Function: ctnRecifraSeg()
+ *
+ * Purpose: Moves one segment record to a new key without exposing the
+ *          plaintext
+ *
+ * Parameters:
+ *   - llaveExp *Lv: Old expanded key
+ *   - llaveExp *Ln: New expanded key
+ *   - contenedor *C: Container description
+ *   - uint64_t i: Segment index
+ *   - bloque Nn: Nonce under the new key, from a base leased for it
+ *   - bytes reg: Record under the old key
+ *   - bytes sal: Record under the new key (may alias reg)
+ *   - bloques B: Scratch blocks (tSeg / 8 blocks)
+ *
+ * Returns:
+ *   - 0: Old tag verified, sal holds the new record
+ *   - 1: Authentication failure (sal must be discarded)
+ *
+ * Details: The old nonce says nothing about what the new key has
+ *          already sealed, so the record takes Nn instead. The padding
+ *          travels inside the last plaintext block unchanged.
+ */
+byte ctnRecifraSeg(llaveExp *Lv, llaveExp *Ln, contenedor *C, uint64_t i, bloque Nn, bytes reg, bytes sal, bloques B)
+	{
+	uint64_t l = ctnLonSeg(C, i);
+	size_t m = (size_t)((l + n_8 - 1) / n_8);
+	bloque A[2];
+	bloque N;
+	bloque T;
+	bloque Tn;
+	cofbEdo D;
+	cofbEdo E;
+
+	N = cargaBE(reg);
+	T = cargaBE(reg + n_8);
+	cargaBEs(reg + ctnReg, B, m);
+	ctnAD(C, i, A);
+	COFBiniExp(&D, opDes, Lv, N, A, 2);
+	COFBiniExp(&E, opCif, Ln, Nn, A, 2);
+	COFBtrans(&D, &E, B, m, B);
+	Tn = COFBfin(&E, 0);
+	if(COFBfin(&D, T) != T)
+		{
+		return(1);
+		}
+
+	guardaBE(sal, Nn);
+	guardaBE(sal + n_8, Tn);
+	guardaBEs(B, sal + ctnReg, m);
+	return(0);
+	}
+
+/*
+ * Function: ctnAleat()
+ *
+ * Purpose: Draws a random base nonce from the kernel
+ *
+ * Returns:
+ *   - bloque: 48 random bits (counter bits cleared)
+ */
+bloque ctnAleat()
+	{
+	bloque x = 0;
+
+	if(getrandom(&x, sizeof(x), 0) != sizeof(x))
+		{
+		fprintf(stderr,"Error al obtener bytes aleatorios\n");
+		exit(1);
+		}
+	return(x & ctnBaseMsk);
+	}
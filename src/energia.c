@@ -0,0 +1,206 @@
+/*
+ * ============================================================================
+ * File: energia.c
+ * Purpose: Energy counters of the Linux powercap RAPL interface
+ *
+ * Each CPU package appears as a zone intel-rapl:P (name "package-P") and
+ * its sub-domains as intel-rapl:P:S ("core", "uncore", "dram"). Every
+ * zone has a microjoule counter, energy_uj, that wraps to 0 after
+ * max_energy_range_uj. AMD processors expose their package counters
+ * under the same names.
+ *
+ * Only the package and core domains are used, summed over all packages.
+ * Recent kernels make energy_uj readable by root only; zones that
+ * cannot be read are left out, and raplAbre() fails when no package
+ * zone is left.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"energia.h"
+#include <sys/stat.h>
+
+/*
+ * Function: raplNum()
+ *
+ * Purpose: Reads one unsigned decimal value from a sysfs file
+ *
+ * Returns:
+ *   - 0: Value read
+ *   - 1: File missing, not readable or malformed
+ */
+static byte raplNum(cad ruta, uint64_t *v)
+	{
+	unsigned long long x;
+	FILE *f = fopen(ruta, "r");
+	byte res;
+
+	if(f == NULL)
+		{
+		return(1);
+		}
+	res = fscanf(f, "%llu", &x) != 1;
+	fclose(f);
+	*v = (uint64_t)x;
+	return(res);
+	}
+
+/*
+ * Function: raplZona()
+ *
+ * Purpose: Adds a zone when its name matches a measured domain and its
+ *          counter can be read
+ *
+ * Parameters:
+ *   - rapl *R: Zone list
+ *   - cad dir: Zone directory
+ */
+static void raplZona(rapl *R, cad dir)
+	{
+	char ruta[0x100];
+	char nom[0x20] = "";
+	uint64_t v;
+	zonaR *Z;
+	FILE *f;
+
+	if(R->t == eneZonas)
+		{
+		return;
+		}
+	Z = &R->z[R->t];
+	snprintf(ruta, sizeof(ruta), "%s/name", dir);
+	if((f = fopen(ruta, "r")) == NULL)
+		{
+		return;
+		}
+	if(fscanf(f, "%31s", nom) != 1)
+		{
+		nom[0] = 0;
+		}
+	fclose(f);
+	if(strncmp(nom, "package", 7) == 0)
+		{
+		Z->dom = enePaq;
+		}
+	else if(strcmp(nom, "core") == 0)
+		{
+		Z->dom = eneNuc;
+		}
+	else
+		{
+		return;
+		}
+
+	snprintf(ruta, sizeof(ruta), "%s/max_energy_range_uj", dir);
+	if(raplNum(ruta, &Z->max) != 0)
+		{
+		return;
+		}
+	snprintf(Z->ruta, sizeof(Z->ruta), "%s/energy_uj", dir);
+	if(raplNum(Z->ruta, &v) != 0)
+		{
+		return;
+		}
+	R->hay[Z->dom] = 1;
+	R->t++;
+	return;
+	}
+
+/*
+ * Function: raplAbre()
+ *
+ * Purpose: Finds the readable package and core counters
+ *
+ * Parameters:
+ *   - rapl *R: Zone list (output)
+ *   - cad raiz: powercap directory (eneRaiz, or a copy for testing)
+ *
+ * Returns:
+ *   - 0: At least one package counter is readable
+ *   - 1: RAPL unavailable (no interface, no package zone or no
+ *        permission)
+ */
+byte raplAbre(rapl *R, cad raiz)
+	{
+	char dir[0x100];
+	struct stat st;
+	size_t p;
+	size_t s;
+
+	memset(R, 0, sizeof(rapl));
+	for(p=0;p<eneZonas;p++)
+		{
+		snprintf(dir, sizeof(dir), "%s/intel-rapl:%zu", raiz, p);
+		if(stat(dir, &st) != 0)
+			{
+			break;
+			}
+		raplZona(R, dir);
+		for(s=0;s<eneZonas;s++)
+			{
+			snprintf(dir, sizeof(dir), "%s/intel-rapl:%zu:%zu", raiz, p, s);
+			if(stat(dir, &st) != 0)
+				{
+				break;
+				}
+			raplZona(R, dir);
+			}
+		}
+	return(R->hay[enePaq] == 0);
+	}
+
+/*
+ * Function: raplLee()
+ *
+ * Purpose: Samples every counter of the list
+ *
+ * Parameters:
+ *   - rapl *R: Zones from raplAbre()
+ *   - uint64_t *e: Counters in microjoules (output, R->t values)
+ *
+ * Returns:
+ *   - 0: All counters read
+ *   - 1: A counter could not be read
+ */
+byte raplLee(rapl *R, uint64_t *e)
+	{
+	size_t i;
+	byte res = 0;
+
+	for(i=0;i<R->t;i++)
+		{
+		res |= raplNum(R->z[i].ruta, &e[i]);
+		}
+	return(res);
+	}
+
+/*
+ * Function: raplJulios()
+ *
+ * Purpose: Energy per domain between two samples
+ *
+ * Parameters:
+ *   - rapl *R: Zones from raplAbre()
+ *   - uint64_t *e0, uint64_t *e1: Samples from raplLee()
+ *   - double *J: Joules per domain (output, eneDoms values)
+ *
+ * Returns: void
+ *
+ * Details: A counter lower than before has wrapped once; the range is
+ *          hundreds of kJ, so at most one wrap fits in a benchmark run
+ */
+void raplJulios(rapl *R, uint64_t *e0, uint64_t *e1, double *J)
+	{
+	size_t i;
+	uint64_t d;
+
+	memset(J, 0, eneDoms * sizeof(double));
+	for(i=0;i<R->t;i++)
+		{
+		d = (e1[i] >= e0[i]) ? e1[i] - e0[i] : R->z[i].max - e0[i] + e1[i];
+		J[R->z[i].dom] += d / 1e6;
+		}
+	return;
+	}
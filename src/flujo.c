@@ -0,0 +1,326 @@
+/*
+ * ============================================================================
+ * File: flujo.c
+ * Purpose: Binary or hex streaming encryption between pipes
+ *
+ * "cifrador flujo" encrypts standard input to standard output as the
+ * data arrives, for use inside pipelines of unknown length:
+ *
+ *   producer | cifrador flujo -k llave.txt -n NONCE | consumer
+ *
+ * Stream Format:
+ *   ciphertext of the input followed by 10* padding (0x80 then zero
+ *   bytes up to a block boundary, a whole block when already aligned),
+ *   then the 8-byte tag. Blocks are big-endian, no associated data.
+ *
+ * With -x both sides are hex text instead (whitespace in the input is
+ * skipped, the output is lowercase digits ending in a newline): each read
+ * is decoded, run through COFB and encoded back while it is in cache,
+ * with the decoder and encoder of the hex I/O mode (arcDeHex(),
+ * arcAHex()).
+ *
+ * Each read() is encrypted as soon as it returns, so a slow producer is
+ * not held back until a buffer fills. The output goes through a salida
+ * writer (see archivo.c): write() in chunks of up to arcTrozo, with a
+ * pipe on stdout enlarged to match.
+ *
+ * Decryption releases plaintext before the tag at the end of the stream
+ * has been checked; only the last block is held back. Consumers must
+ * treat the output as untrusted unless the exit status is 0.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"flujo.h"
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+
+/*
+ * Function: leeAlgo()
+ *
+ * Purpose: One read(), retried only when interrupted
+ */
+static ssize_t leeAlgo(int fd, bytes p, size_t t)
+	{
+	ssize_t l;
+
+	do
+		{
+		l = read(fd, p, t);
+		}
+	while(l < 0 && errno == EINTR);
+	return(l);
+	}
+
+/*
+ * Function: leeFlujo()
+ *
+ * Purpose: Input bytes from one read(), decoded first in hex mode
+ *
+ * Parameters:
+ *   - int fd: Input descriptor
+ *   - bytes p: Destination
+ *   - size_t t: Room in p
+ *   - char *h: Hex buffer of 2 * t characters, NULL for binary input
+ *   - int *med: Pending high nibble for arcDeHex()
+ *
+ * Returns:
+ *   - ssize_t: Bytes stored in p, 0 at the end of the input, -1 on a
+ *              read error or a character that is not hex
+ *
+ * Details: Reads holding only whitespace or a single digit are followed
+ *          by another read, so 0 still means end of input
+ */
+static ssize_t leeFlujo(int fd, bytes p, size_t t, char *h, int *med)
+	{
+	ssize_t l;
+	size_t d = 0;
+
+	if(h == NULL)
+		{
+		return(leeAlgo(fd, p, t));
+		}
+	while(d == 0)
+		{
+		l = leeAlgo(fd, (bytes)h, 2 * t);
+		if(l <= 0)
+			{
+			return(l);
+			}
+		if(arcDeHex(h, (size_t)l, p, &d, med) != 0)
+			{
+			return(-1);
+			}
+		}
+	return((ssize_t)d);
+	}
+
+/*
+ * Function: emite()
+ *
+ * Purpose: Runs the COFB operation over whole blocks and emits them
+ *
+ * Parameters:
+ *   - cofbEdo *E: Stream state
+ *   - salida *S: Writer
+ *   - bytes e: Input bytes (overwritten in hex mode)
+ *   - size_t t: Bytes (multiple of 8, at most S->max, S->max / 2 in
+ *               hex mode)
+ *   - bloques B: Scratch blocks
+ *   - byte hex: 1 to emit hex digits instead of bytes
+ *
+ * Returns:
+ *   - 0: Emitted
+ *   - 1: Write error
+ */
+static byte emite(cofbEdo *E, salida *S, bytes e, size_t t, bloques B, byte hex)
+	{
+	bytes x = salPide(S, hex ? 2 * t : t);
+
+	cargaBEs(e, B, t / n_8);
+	COFBsig(E, B, t / n_8, B);
+	if(hex != 0)
+		{
+		guardaBEs(B, e, t / n_8);
+		arcAHex(e, (char *)x, t);
+		}
+	else
+		{
+		guardaBEs(B, x, t / n_8);
+		}
+	return(salEmite(S, hex ? 2 * t : t));
+	}
+
+/*
+ * Function: escCola()
+ *
+ * Purpose: Writes the tail of the stream (tag or last plaintext bytes)
+ *
+ * Parameters:
+ *   - int fd: Output descriptor
+ *   - bytes p: Bytes to write
+ *   - size_t t: Bytes in p (at most 8)
+ *   - byte hex: 1 to write them as hex digits plus the final newline
+ *
+ * Returns:
+ *   - 0: Written
+ *   - 1: Write error
+ */
+static byte escCola(int fd, bytes p, size_t t, byte hex)
+	{
+	char s[2 * n_8 + 1];
+
+	if(hex == 0)
+		{
+		return(escTodo(fd, p, t));
+		}
+	arcAHex(p, s, t);
+	s[2 * t] = '\n';
+	return(escTodo(fd, (bytes)s, 2 * t + 1));
+	}
+
+/*
+ * Function: usoFlujo()
+ *
+ * Purpose: Prints the usage of the flujo subcommand
+ */
+static int usoFlujo()
+	{
+	fprintf(stderr,"Uso: cifrador flujo [-d] [-x] -k LLAVE -n NONCE < entrada > salida\n");
+	fprintf(stderr,"     LLAVE: archivo con la llave en 32 digitos hex; NONCE: 16 digitos hex\n");
+	return(1);
+	}
+
+/*
+ * Function: flujo()
+ *
+ * Purpose: Entry point of "cifrador flujo"
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "flujo")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -d:       Decrypt (default: encrypt)
+ *   - -x:       Hex text input and output (default: binary)
+ *   - -k FILE:  Key file (required)
+ *   - -n HEX:   Nonce, 16 hex digits (required, never reuse per key)
+ *
+ * Returns:
+ *   - int: 0 on success, 1 on a usage, I/O, format or tag failure
+ */
+int flujo(int argc, char *argv[])
+	{
+	salida S;
+	cofbEdo E;
+	llaveExp L;
+	bloque K[2];
+	bloque N;
+	bloque T;
+	bloques B;
+	bytes e;
+	byte u[n_8];
+	char *h = NULL;
+	cad rutaK = NULL;
+	cad nonce = NULL;
+	byte op = opCif;
+	byte hex = 0;
+	byte err = 0;
+	size_t q = 0;
+	size_t p;
+	size_t ret;
+	size_t tMax;
+	ssize_t l = 0;
+	int med = -1;
+	int opc;
+
+	optind = 1;
+	while((opc = getopt(argc, argv, "dxk:n:")) != -1)
+		{
+		switch(opc)
+			{
+			case 'd':
+				op = opDes;
+				break;
+			case 'x':
+				hex = 1;
+				break;
+			case 'k':
+				rutaK = optarg;
+				break;
+			case 'n':
+				nonce = optarg;
+				break;
+			default:
+				return(usoFlujo());
+			}
+		}
+	if(rutaK == NULL || nonce == NULL || sscanf(nonce, "%16" SCNx64, &N) != 1)
+		{
+		return(usoFlujo());
+		}
+	if(leeLlave(rutaK, K) != 0)
+		{
+		fprintf(stderr,"Llave invalida en %s\n", rutaK);
+		return(1);
+		}
+	expandeLlave(&L, K);
+	COFBiniExp(&E, op, &L, N, NULL, 0);
+
+	// Decryption keeps the last block and the tag (16 bytes) back
+	ret = op == opCif ? 0 : 2 * n_8;
+	if(salAbre(&S, STDOUT_FILENO) != 0 || (e = malloc(S.max + 3 * n_8)) == NULL || (B = malloc(S.max)) == NULL
+		|| (hex != 0 && (h = malloc(S.max + 2 * ret)) == NULL))
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+
+	// Hex output doubles every emission, so half as many bytes fit
+	tMax = hex ? S.max / 2 : S.max;
+	while(err == 0 && (l = leeFlujo(STDIN_FILENO, e + q, tMax + ret - q, h, &med)) > 0)
+		{
+		q += (size_t)l;
+		p = q > ret ? (q - ret) - (q - ret) % n_8 : 0;
+		if(p > 0)
+			{
+			err = emite(&E, &S, e, p, B, hex);
+			memmove(e, e + p, q - p);
+			q -= p;
+			}
+		}
+	if(l < 0)
+		{
+		fprintf(stderr,hex ? "Entrada hex invalida\n" : "Error al leer la entrada\n");
+		err = 1;
+		}
+	if(err == 0 && med >= 0)
+		{
+		fprintf(stderr,"Numero impar de digitos hex\n");
+		err = 1;
+		}
+
+	if(err == 0 && op == opCif)
+		{
+		// Final padded block and tag
+		memset(e + q, 0, n_8 - q);
+		e[q] = fluPad;
+		err = emite(&E, &S, e, n_8, B, hex);
+		T = COFBfin(&E, 0);
+		guardaBE(e, T);
+		err |= escCola(S.fd, e, n_8, hex);
+		}
+	else if(err == 0)
+		{
+		if(q != ret)
+			{
+			fprintf(stderr,"Flujo truncado\n");
+			err = 1;
+			}
+		else
+			{
+			B[0] = cargaBE(e);
+			T = cargaBE(e + n_8);
+			COFBsig(&E, B, 1, B);
+			guardaBE(u, B[0]);
+			for(p=n_8-1;p>0 && u[p]==0;p--);
+			if(COFBfin(&E, T) != T || u[p] != fluPad)
+				{
+				fprintf(stderr,"Etiqueta invalida\n");
+				err = 1;
+				}
+			else
+				{
+				err = escCola(S.fd, u, p, hex);
+				}
+			}
+		}
+	free(e);
+	free(B);
+	free(h);
+	salCierra(&S);
+	return(err);
+	}
@@ -0,0 +1,602 @@
+/*
+ * ============================================================================
+ * File: generador.c
+ * Purpose: Deterministic workload and test-vector generator
+ *
+ * Invoked as "cifrador gen [options]". Every record holds a key, a nonce,
+ * associated data and a message drawn from the seeded aleat() generator,
+ * plus the ciphertext and tag computed with the reference COFBbuf().
+ * The same seed and options always produce byte-identical output.
+ *
+ * Text Output (entrada.ent layout, one record):
+ *   <key, 32 hex>
+ *   <nonce, 8 hex>
+ *   <AD blocks, hex>
+ *   <message blocks, hex>
+ *   .
+ *   <AD blocks, hex>
+ *   <ciphertext blocks, hex>
+ *   <tag, 16 hex>
+ *   (blank line)
+ *
+ * Binary Output (all integers big-endian):
+ *   Header: "CFBV" | version (1 byte)
+ *   Record: key (16) | nonce (8) | a (4) | m (4) |
+ *           AD (8a) | message (8m) | ciphertext (8m) | tag (8)
+ *
+ * Verification (-v):
+ *   Records in the text layout are read back from stdin (the tag line
+ *   may be missing, as in entrada.ent) and recomputed with COFBbuf() on
+ *   the chosen engine and path. Each record prints its tag and "ok" only
+ *   if the ciphertext (and tag, when given) match, vCOFBbuf() recovers
+ *   the message and rejects the ciphertext with one bit flipped.
+ *
+ * Size Distributions (in 64-bit blocks):
+ *   - "N":       always N blocks
+ *   - "MIN-MAX": uniform between MIN and MAX
+ *   - "mezcla":  packet-like mix dominated by 16-128 byte messages with
+ *                a long tail up to 64 KiB
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"generador.h"
+#include <ctype.h>
+#include <unistd.h>
+
+#define semGen	0x4d69646f72693634	//semilla por omision
+#define bufGen	0x100000		//bytes del bufer de salida
+
+/*
+ * Packet-like Size Mix
+ *
+ * Purpose: Buckets of the "mezcla" distribution
+ * Columns: cumulative weight (out of 100), min blocks, max blocks
+ */
+static const uint64_t mezcla[][3] = {
+	{  30,    2,    2},	//16 bytes
+	{  55,    4,    4},	//32 bytes
+	{  75,    8,    8},	//64 bytes
+	{  85,   16,   16},	//128 bytes
+	{  95,   17,  512},	//136 bytes a 4 KiB
+	{ 100,  513, 8192}	//4 KiB a 64 KiB
+	};
+
+static const char hexd[0x10] = "0123456789abcdef";
+
+/*
+ * Function: leeDist()
+ *
+ * Purpose: Parses a size distribution specification
+ *
+ * Parameters:
+ *   - cad s: "N", "MIN-MAX" or "mezcla"
+ *   - dist *D: Parsed distribution (output)
+ *
+ * Returns:
+ *   - 0: Valid specification
+ *   - 1: Invalid specification (sizes must be at least one block)
+ */
+byte leeDist(cad s, dist *D)
+	{
+	char *fin;
+
+	if(strcmp(s,"mezcla") == 0)
+		{
+		D->tipo	= distMezcla;
+		D->min	= mezcla[0][1];
+		D->max	= mezcla[sizeof(mezcla)/sizeof(mezcla[0]) - 1][2];
+		return(0);
+		}
+
+	D->min = strtoull(s, &fin, 10);
+	D->max = D->min;
+	D->tipo = distFija;
+	if(*fin == '-')
+		{
+		D->max = strtoull(fin+1, &fin, 10);
+		D->tipo = distUnif;
+		}
+	return(*fin != 0 || D->min == 0 || D->max < D->min);
+	}
+
+/*
+ * Function: muestraDist()
+ *
+ * Purpose: Draws one size from a distribution
+ *
+ * Parameters:
+ *   - dist *D: Distribution parsed by leeDist()
+ *   - bloque *edo: aleat() state
+ *
+ * Returns:
+ *   - uint64_t: Size in blocks
+ */
+uint64_t muestraDist(dist *D, bloque *edo)
+	{
+	uint64_t p;
+	byte i = 0;
+
+	switch(D->tipo)
+		{
+		case distUnif:
+			return(D->min + aleat(edo) % (D->max - D->min + 1));
+		case distMezcla:
+			p = aleat(edo) % 100;
+			while(p >= mezcla[i][0])
+				{
+				i++;
+				}
+			return(mezcla[i][1] + aleat(edo) % (mezcla[i][2] - mezcla[i][1] + 1));
+		}
+	return(D->min);
+	}
+
+/*
+ * Function: hexBloq()
+ *
+ * Purpose: Writes blocks as lowercase hex without separators
+ *
+ * Parameters:
+ *   - char *p: Destination (16 characters per block)
+ *   - bloques B: Blocks to encode
+ *   - uint64_t t: Number of blocks
+ *
+ * Returns:
+ *   - char *: Position just after the last character written
+ */
+static char * hexBloq(char *p, bloques B, uint64_t t)
+	{
+	uint64_t i;
+	byte j;
+
+	for(i=0;i<t;i++)
+		{
+		for(j=0;j<n_4;j++)
+			{
+			*p++ = hexd[(B[i] >> (0x3c - (j<<2))) & 0xf];
+			}
+		}
+	return(p);
+	}
+
+/*
+ * Function: binBloq()
+ *
+ * Purpose: Writes blocks in big-endian byte order
+ *
+ * Parameters:
+ *   - bytes p: Destination (8 bytes per block)
+ *   - bloques B: Blocks to encode
+ *   - uint64_t t: Number of blocks
+ *
+ * Returns:
+ *   - bytes: Position just after the last byte written
+ */
+static bytes binBloq(bytes p, bloques B, uint64_t t)
+	{
+	guardaBEs(B, p, (size_t)t);
+	return(p + t * n_8);
+	}
+
+/*
+ * Function: deHex()
+ *
+ * Purpose: Decodes a line of hex digits into blocks
+ *
+ * Parameters:
+ *   - cad l: Line (16 digits per block, no separators)
+ *   - uint64_t *t: Number of blocks (output)
+ *
+ * Returns:
+ *   - bloques: Blocks (caller frees), or NULL if the line is not whole
+ *              blocks of hex digits
+ */
+static bloques deHex(cad l, uint64_t *t)
+	{
+	size_t d = strspn(l, "0123456789abcdefABCDEF");
+	bloques B;
+	uint64_t i;
+	char g[n_4+1];
+
+	*t = d / n_4;
+	if(l[d] != 0 || d == 0 || d % n_4 != 0 || (B = malloc(*t * sizeof(bloque))) == NULL)
+		{
+		return(NULL);
+		}
+	g[n_4] = 0;
+	for(i=0;i<*t;i++)
+		{
+		memcpy(g, l + i * n_4, n_4);
+		B[i] = strtoull(g, NULL, 16);
+		}
+	return(B);
+	}
+
+/*
+ * Function: verReg()
+ *
+ * Purpose: Checks one record read back by verifica()
+ *
+ * Parameters:
+ *   - cad c[7]: Lines of the record: key, nonce, AD, message, AD,
+ *               ciphertext and, when nc is 7, tag
+ *   - byte nc: Number of lines (6 or 7)
+ *   - bloque *T: Computed tag (output)
+ *
+ * Returns:
+ *   - 0: Record reproduced
+ *   - 1: Malformed record or mismatch
+ */
+static byte verReg(cad c[7], byte nc, bloque *T)
+	{
+	bloques V[7] = {NULL};
+	uint64_t t[7];
+	bloques X = NULL;
+	bloques D = NULL;
+	byte j;
+	byte err = 0;
+
+	*T = 0;
+	for(j=0;j<nc;j++)
+		{
+		// The nonce has 8 digits, as printed by gen and in entrada.ent
+		if(j != 1 && (V[j] = deHex(c[j], &t[j])) == NULL)
+			{
+			err = 1;
+			}
+		}
+	err = err || strlen(c[1]) != n_8 || strspn(c[1], "0123456789abcdefABCDEF") != n_8 || t[0] != 2
+		|| t[4] != t[2] || memcmp(V[4], V[2], t[2] * sizeof(bloque)) != 0
+		|| t[5] != t[3] || (nc == 7 && t[6] != 1);
+	if(err == 0)
+		{
+		X = malloc(t[3] * sizeof(bloque));
+		D = malloc(t[3] * sizeof(bloque));
+		if(X == NULL || D == NULL)
+			{
+			fprintf(stderr,"Error al asignar memoria\n");
+			exit(1);
+			}
+		*T = COFBbuf(V[0], strtoull(c[1], NULL, 16), V[2], t[2], V[3], t[3], X);
+		err = memcmp(X, V[5], t[3] * sizeof(bloque)) != 0 || (nc == 7 && *T != V[6][0])
+			|| vCOFBbuf(V[0], strtoull(c[1], NULL, 16), V[2], t[2], V[5], t[3], D, *T) != 0
+			|| memcmp(D, V[3], t[3] * sizeof(bloque)) != 0;
+
+		// Tampered ciphertext must be rejected
+		X[0] ^= 1;
+		err = err || vCOFBbuf(V[0], strtoull(c[1], NULL, 16), V[2], t[2], X, t[3], D, *T) != 1;
+		}
+	for(j=0;j<nc;j++)
+		{
+		free(V[j]);
+		}
+	free(X);
+	free(D);
+	return(err);
+	}
+
+/*
+ * Function: verifica()
+ *
+ * Purpose: Reads text records from stdin and checks every one
+ *
+ * Returns:
+ *   - int: 0 if every record was reproduced, 1 otherwise
+ *
+ * Details: A record is a run of non-empty lines up to a blank line
+ *          that includes the "." separator; other runs (the key and
+ *          plaintext pairs at the end of entrada.ent) are skipped. One
+ *          line per record goes to stdout: the computed tag and "ok" or
+ *          "FALLA"
+ */
+static int verifica()
+	{
+	char *lin = NULL;
+	size_t cap = 0;
+	ssize_t l;
+	cad c[7];
+	byte nc = 0;
+	byte extra = 0;
+	byte punto = 0;
+	bloque T;
+	uint64_t reg = 0;
+	uint64_t mal = 0;
+	byte j;
+
+	do
+		{
+		l = getline(&lin, &cap, stdin);
+		while(l > 0 && isspace((unsigned char)lin[l-1]))
+			{
+			lin[--l] = 0;
+			}
+		if(l > 0 && strcmp(lin, ".") == 0)
+			{
+			punto = 1;
+			}
+		else if(l > 0)
+			{
+			if(nc < 7)
+				{
+				c[nc++] = strdup(lin);
+				}
+			else
+				{
+				extra = 1;
+				}
+			}
+		else if(nc > 0 && punto == 0)
+			{
+			// Lines without the "." separator are not a record
+			for(j=0;j<nc;j++)
+				{
+				free(c[j]);
+				}
+			nc = 0;
+			extra = 0;
+			}
+		else if(nc > 0)
+			{
+			// End of a record: blank line or end of input
+			reg++;
+			if(extra != 0 || nc < 6 || verReg(c, nc, &T) != 0)
+				{
+				mal++;
+				printf("%016" PRIx64 " FALLA\n", extra != 0 || nc < 6 ? 0 : T);
+				}
+			else
+				{
+				printf("%016" PRIx64 " ok\n", T);
+				}
+			for(j=0;j<nc;j++)
+				{
+				free(c[j]);
+				}
+			nc = 0;
+			extra = 0;
+			punto = 0;
+			}
+		}
+	while(l >= 0);
+	free(lin);
+	fprintf(stderr,"%" PRIu64 " registros, %" PRIu64 " con error\n", reg, mal);
+	return(mal != 0 || reg == 0);
+	}
+
+/*
+ * Function: usoGen()
+ *
+ * Purpose: Prints the usage of the gen subcommand
+ */
+static int usoGen()
+	{
+	fprintf(stderr,"Uso: cifrador gen [-s semilla] [-r registros] [-k llaves] [-a dist] [-m dist] [-b] [-o salida] [-e motor] [-g]\n");
+	fprintf(stderr,"     cifrador gen -v [-e motor] [-g] < vectores\n");
+	fprintf(stderr,"     dist: N | MIN-MAX | mezcla (en bloques de 64 bits)\n");
+	return(1);
+	}
+
+/*
+ * Function: generador()
+ *
+ * Purpose: Entry point of "cifrador gen"
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "gen")
+ *   - char *argv[]: Options
+ *
+ * Options:
+ *   - -s SEED:    Generator seed (default fixed)
+ *   - -r COUNT:   Number of records (default 1)
+ *   - -k COUNT:   Draw keys from a pool of COUNT keys (default: one
+ *                 fresh key per record)
+ *   - -a DIST:    AD size distribution (default "1")
+ *   - -m DIST:    Message size distribution (default "mezcla")
+ *   - -b:         Binary output instead of entrada.ent text
+ *   - -o FILE:    Output file (default stdout)
+ *   - -e ENGINE:  Midori engine of COFBbuf() (default: the fastest)
+ *   - -g:         Generic COFB path only (no fixed-shape kernels)
+ *   - -v:         Verify records read from stdin instead (see above)
+ *
+ * Returns:
+ *   - int: 0 on success, 1 on usage or I/O errors
+ *
+ * Details:
+ *   - Nonces are limited to 32 bits because the text reader of
+ *     cifrador parses the nonce with "%08llx"
+ *   - Records are formatted into one reusable buffer and written with
+ *     a single fwrite() each
+ */
+int generador(int argc, char *argv[])
+	{
+	int opc;
+	uint64_t reg = 1;
+	uint64_t nLlaves = 0;
+	uint64_t i;
+	uint64_t j;
+	uint64_t a;
+	uint64_t m;
+	uint64_t cap = 0;
+	byte bin = 0;
+	bloque sem = semGen;
+	bloque edoK;
+	bloque K[2];
+	bloque N;
+	bloque T;
+	bloques A = NULL;
+	bloques M = NULL;
+	bloques C = NULL;
+	char *buf = NULL;
+	char *p;
+	dist dA = {distFija, 1, 1};
+	dist dM = {distMezcla, 2, 8192};
+	FILE *f = stdout;
+	cad ruta = NULL;
+	byte ver = 0;
+
+	optind = 1;
+	while((opc = getopt(argc, argv, "s:r:k:a:m:bo:e:gv")) != -1)
+		{
+		switch(opc)
+			{
+			case 's':
+				sem = strtoull(optarg, NULL, 0);
+				break;
+			case 'r':
+				reg = strtoull(optarg, NULL, 10);
+				break;
+			case 'k':
+				nLlaves = strtoull(optarg, NULL, 10);
+				break;
+			case 'a':
+				if(leeDist(optarg, &dA) != 0)
+					{
+					return(usoGen());
+					}
+				break;
+			case 'm':
+				if(leeDist(optarg, &dM) != 0)
+					{
+					return(usoGen());
+					}
+				break;
+			case 'b':
+				bin = 1;
+				break;
+			case 'o':
+				ruta = optarg;
+				break;
+			case 'e':
+				for(j=0;j<nMot && strcmp(optarg, nomMot[j]) != 0;j++);
+				if(j == nMot || hayMot((byte)j) == 0)
+					{
+					fprintf(stderr,"Motor no disponible: %s\n",optarg);
+					return(1);
+					}
+				nucMot = (byte)j;
+				break;
+			case 'g':
+				cofbEsp = 0;
+				break;
+			case 'v':
+				ver = 1;
+				break;
+			default:
+				return(usoGen());
+			}
+		}
+	if(ver != 0)
+		{
+		return(verifica());
+		}
+
+	if(ruta != NULL && (f = fopen(ruta, bin ? "wb" : "w")) == NULL)
+		{
+		fprintf(stderr,"Error al abrir %s\n",ruta);
+		return(1);
+		}
+	setvbuf(f, NULL, _IOFBF, bufGen);
+	edoK = sem ^ 0xa5a5a5a5a5a5a5a5;
+
+	if(bin != 0)
+		{
+		fwrite(genMagia, 1, 4, f);
+		fputc(genVer, f);
+		}
+
+	for(i=0;i<reg;i++)
+		{
+		a = muestraDist(&dA, &sem);
+		m = muestraDist(&dM, &sem);
+
+		// Grow the block and output buffers to the largest record so far
+		if(a + m > cap)
+			{
+			cap = (a + m) << 1;
+			A = realloc(A, cap * sizeof(bloque));
+			M = realloc(M, cap * sizeof(bloque));
+			C = realloc(C, cap * sizeof(bloque));
+			buf = realloc(buf, cap * 0x30 + 0x80);
+			if(A == NULL || M == NULL || C == NULL || buf == NULL)
+				{
+				fprintf(stderr,"Error al asignar memoria\n");
+				exit(1);
+				}
+			}
+
+		// Key: fresh per record or drawn from a fixed pool
+		if(nLlaves > 0)
+			{
+			edoK = (sem ^ 0xa5a5a5a5a5a5a5a5) + (aleat(&sem) % nLlaves);
+			}
+		K[0] = aleat(&edoK);
+		K[1] = aleat(&edoK);
+		N = aleat(&sem) & 0xffffffff;
+		for(j=0;j<a;j++)
+			{
+			A[j] = aleat(&sem);
+			}
+		for(j=0;j<m;j++)
+			{
+			M[j] = aleat(&sem);
+			}
+
+		T = COFBbuf(K, N, A, a, M, m, C);
+
+		p = buf;
+		if(bin != 0)
+			{
+			p = (char *)binBloq((bytes)p, K, 2);
+			p = (char *)binBloq((bytes)p, &N, 1);
+			*p++ = (char)(a >> 24);	*p++ = (char)(a >> 16);	*p++ = (char)(a >> 8);	*p++ = (char)a;
+			*p++ = (char)(m >> 24);	*p++ = (char)(m >> 16);	*p++ = (char)(m >> 8);	*p++ = (char)m;
+			p = (char *)binBloq((bytes)p, A, a);
+			p = (char *)binBloq((bytes)p, M, m);
+			p = (char *)binBloq((bytes)p, C, m);
+			p = (char *)binBloq((bytes)p, &T, 1);
+			}
+		else
+			{
+			p = hexBloq(p, K, 2);
+			*p++ = '\n';
+			// Nonce is printed with 8 digits, as in entrada.ent
+			for(j=0;j<n_8;j++)
+				{
+				*p++ = hexd[(N >> (0x1c - (j<<2))) & 0xf];
+				}
+			*p++ = '\n';
+			p = hexBloq(p, A, a);
+			*p++ = '\n';
+			p = hexBloq(p, M, m);
+			*p++ = '\n';
+			*p++ = '.';
+			*p++ = '\n';
+			p = hexBloq(p, A, a);
+			*p++ = '\n';
+			p = hexBloq(p, C, m);
+			*p++ = '\n';
+			p = hexBloq(p, &T, 1);
+			*p++ = '\n';
+			*p++ = '\n';
+			}
+		if(fwrite(buf, 1, p - buf, f) != (size_t)(p - buf))
+			{
+			fprintf(stderr,"Error al escribir la salida\n");
+			return(1);
+			}
+		}
+
+	free(A);
+	free(M);
+	free(C);
+	free(buf);
+	if(fflush(f) != 0 || (ruta != NULL && fclose(f) != 0))
+		{
+		fprintf(stderr,"Error al escribir la salida\n");
+		return(1);
+		}
+	return(0);
+	}
@@ -0,0 +1,343 @@
+/*
+ * ============================================================================
+ * File: lote.c
+ * Purpose: Batch Midori-64 encryption of independent blocks under one key
+ *
+ * One kernel source (loteCuerpo.h) written against the vector operations
+ * of simd.h is compiled here once per instruction set:
+ *
+ *   - loteEsc:  64-bit words (4 blocks per word), any target
+ *   - loteSSE2: XMM registers (8 blocks), every x86-64 host
+ *   - loteAVX2: YMM registers (16 blocks)
+ *
+ * Only the kernel functions carry target attributes, so the program
+ * itself needs no -m flags and runs on any x86-64 CPU; loteIni() picks
+ * the widest instance the CPU supports.
+ *
+ * Bit-plane Layout:
+ *   A block becomes four 16-bit planes, plane k holding bit k of every
+ *   nibble. Nibble i sits at bit lotPos[i] of each plane. This order
+ *   keeps every MixColumn column in four adjacent bits and turns
+ *   ShuffleCell into six shift-and-mask terms. SubCell is a boolean
+ *   circuit over the four planes, so no byte shuffle is needed and SSE2
+ *   suffices.
+ *
+ * Scope:
+ *   COFB chains every Midori call on the previous output, so one message
+ *   offers no independent blocks; only the benchmarks use these kernels.
+ *   The file paths (paralelo.c, flujo.c) run on the nucMot engines.
+ *
+ * Conversion:
+ *   Blocks enter and leave the planes through four delta swaps (a 16x4
+ *   bit transpose inside the 64-bit word) and two 256-entry tables that
+ *   move the nibbles to lotPos[]. This is scalar code shared by all
+ *   instances.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"lote.h"
+
+#define rep16(x)	{x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x}
+
+#define ctP0	0x00	//celdas que ShuffleCell deja en su lugar
+#define ctP2	0x01	//celdas que suben 2 bits
+#define ctP4	0x02	//celdas que suben 4 bits
+#define ctP10	0x03	//celdas que suben 10 bits
+#define ctQ6	0x04	//celdas que bajan 6 bits
+#define ctQ10	0x05	//celdas que bajan 10 bits
+#define ctS1	0x06	//bits pares de cada par (MixColumn)
+#define ctS2	0x07	//pares bajos de cada columna (MixColumn)
+
+/*
+ * Engine Selection
+ *
+ * loteMot: Batch kernel used by midoriLote(); set by loteIni() to the
+ *          widest instance this CPU supports, benchmarks may override it
+ * nomLote: Labels used in reports, indexed by loteEsc/loteSSE2/loteAVX2
+ * lotCarr: Blocks per vector of each instance
+ */
+byte loteMot = loteEsc;
+const char * nomLote[nLote] = {"esc", "sse2", "avx2"};
+static const byte lotCarr[nLote] = {0x04, 0x08, 0x10};
+
+/*
+ * lotPos: Plane bit of each nibble (nibble 0 = most significant)
+ */
+static const byte lotPos[nxn] = {0x0,0x2,0x1,0x3,0x5,0x7,0x4,0x6,0xf,0xd,0xc,0xe,0x8,0xa,0xb,0x9};
+
+/*
+ * lotCte: Kernel masks replicated to loteMax lanes (indexed by ct*)
+ */
+static const uint16_t lotCte[8][loteMax] __attribute__((aligned(32))) = {
+	rep16(0x0401),	//ctP0
+	rep16(0x8180),	//ctP2
+	rep16(0x1040),	//ctP4
+	rep16(0x6800),	//ctP10
+	rep16(0x022a),	//ctQ6
+	rep16(0x0014),	//ctQ10
+	rep16(0x5555),	//ctS1
+	rep16(0x3333)	//ctS2
+	};
+
+/*
+ * tEnt, tSal: Move the bits of a plane between the transpose order
+ *             (bit j = nibble 15-j) and lotPos[], one byte at a time
+ */
+static uint16_t tEnt[2][0x100];
+static uint16_t tSal[2][0x100];
+
+#define simdISA simdEsc
+#include <simd.h>
+#include <loteCuerpo.h>
+#undef simdISA
+
+#if defined(__x86_64__) || defined(__i386__)
+#define loteX86
+#define simdISA simdSSE2
+#include <simd.h>
+#include <loteCuerpo.h>
+#undef simdISA
+#define simdISA simdAVX2
+#include <simd.h>
+#include <loteCuerpo.h>
+#undef simdISA
+#endif
+
+/*
+ * Kernel instances, indexed by loteEsc/loteSSE2/loteAVX2
+ */
+static void (* const lotNuc[nLote])(llaveLote *, uint16_t *, size_t) = {
+	loteRondas_esc,
+#ifdef loteX86
+	loteRondas_sse2,
+	loteRondas_avx2
+#else
+	NULL,
+	NULL
+#endif
+	};
+
+/*
+ * Function: hayLote()
+ *
+ * Purpose: Tells whether a batch kernel can run on this CPU
+ *
+ * Parameters:
+ *   - byte mot: loteEsc, loteSSE2 or loteAVX2
+ *
+ * Returns:
+ *   - 1: Kernel available
+ *   - 0: Kernel unknown, not compiled for this target or not supported
+ */
+byte hayLote(byte mot)
+	{
+	if(mot >= nLote || lotNuc[mot] == NULL)
+		{
+		return(0);
+		}
+	switch(mot)
+		{
+#ifdef loteX86
+		case loteSSE2:
+			return(__builtin_cpu_supports("sse2") != 0);
+		case loteAVX2:
+			return(__builtin_cpu_supports("avx2") != 0);
+#endif
+		}
+	return(1);
+	}
+
+/*
+ * Function: loteIni()
+ *
+ * Purpose: Builds the layout tables and selects the default kernel
+ *          before main() runs
+ */
+static void __attribute__((constructor)) loteIni()
+	{
+	byte j;
+	uint16_t v;
+
+	for(v=0;v<0x100;v++)
+		{
+		tEnt[0][v] = tEnt[1][v] = tSal[0][v] = tSal[1][v] = 0;
+		for(j=0;j<n_8;j++)
+			{
+			if((v >> j) & 1)
+				{
+				tEnt[0][v] |= (uint16_t)1 << lotPos[0xf - j];
+				tEnt[1][v] |= (uint16_t)1 << lotPos[0x7 - j];
+				}
+			}
+		}
+	// tSal inverts tEnt: plane bit lotPos[i] goes back to bit 15-i
+	for(j=0;j<nxn;j++)
+		{
+		tSal[lotPos[j] >> 3][1 << (lotPos[j] & 7)] = (uint16_t)1 << (0xf - j);
+		}
+	for(v=0;v<0x100;v++)
+		{
+		for(j=0;j<n_8;j++)
+			{
+			tSal[0][v] |= ((v >> j) & 1) ? tSal[0][1 << j] : 0;
+			tSal[1][v] |= ((v >> j) & 1) ? tSal[1][1 << j] : 0;
+			}
+		}
+
+	loteMot = hayLote(loteAVX2) ? loteAVX2 : hayLote(loteSSE2) ? loteSSE2 : loteEsc;
+	return;
+	}
+
+/*
+ * Function: intercambia()
+ *
+ * Purpose: Delta swap: exchanges the bits selected by m with the bits d
+ *          positions above them
+ */
+static inline bloque intercambia(bloque x, byte d, bloque m)
+	{
+	bloque t = ((x >> d) ^ x) & m;
+
+	return(x ^ t ^ (t << d));
+	}
+
+/*
+ * Function: aPlanos()
+ *
+ * Purpose: Splits a block into its four planes
+ *
+ * Parameters:
+ *   - bloque x: Block
+ *   - uint16_t *pl: Planes (4 rows of loteMax lanes)
+ *   - size_t j: Lane of the block
+ *
+ * Details: The delta swaps exchange nibble-index and bit-index bits of
+ *          the position, leaving plane k in bits 16k..16k+15
+ */
+static inline void aPlanos(bloque x, uint16_t *pl, size_t j)
+	{
+	byte k;
+	uint16_t w;
+
+	x = intercambia(x, 3, 0x0a0a0a0a0a0a0a0a);
+	x = intercambia(x, 6, 0x00cc00cc00cc00cc);
+	x = intercambia(x, 12, 0x0000f0f00000f0f0);
+	x = intercambia(x, 24, 0x00000000ff00ff00);
+	for(k=0;k<4;k++)
+		{
+		w = (uint16_t)(x >> (k << 4));
+		pl[k * loteMax + j] = tEnt[0][w & 0xff] | tEnt[1][w >> 8];
+		}
+	return;
+	}
+
+/*
+ * Function: dePlanos()
+ *
+ * Purpose: Joins four planes back into a block (inverse of aPlanos())
+ */
+static inline bloque dePlanos(uint16_t *pl, size_t j)
+	{
+	byte k;
+	uint16_t w;
+	bloque x = 0;
+
+	for(k=0;k<4;k++)
+		{
+		w = pl[k * loteMax + j];
+		x |= (bloque)(tSal[0][w & 0xff] | tSal[1][w >> 8]) << (k << 4);
+		}
+	x = intercambia(x, 24, 0x00000000ff00ff00);
+	x = intercambia(x, 12, 0x0000f0f00000f0f0);
+	x = intercambia(x, 6, 0x00cc00cc00cc00cc);
+	return(intercambia(x, 3, 0x0a0a0a0a0a0a0a0a));
+	}
+
+/*
+ * Function: desempacaLote()
+ *
+ * Purpose: Converts an expanded key into replicated key planes
+ *
+ * Parameters:
+ *   - llaveLote *X: Key planes (output)
+ *   - llaveExp *L: Key expanded by expandeLlave()
+ *
+ * Returns: void
+ *
+ * Details: Planes 2 and 3 of the round keys and of the final whitening
+ *          are complemented: they absorb the constant terms of Sb0 that
+ *          loteSb() leaves out (see loteCuerpo.h)
+ */
+void desempacaLote(llaveLote *X, llaveExp *L)
+	{
+	uint16_t pl[4][loteMax];
+	size_t i;
+	size_t j;
+	byte k;
+
+	aPlanos(L->WK, pl[0], 0);
+	for(k=0;k<4;k++)
+		{
+		for(j=0;j<loteMax;j++)
+			{
+			X->WK[k][j] = pl[k][0];
+			X->WF[k][j] = pl[k][0] ^ (k >= 2 ? 0xffff : 0);
+			}
+		}
+	for(i=0;i<=r-2;i++)
+		{
+		aPlanos(L->RK[i], pl[0], 0);
+		for(k=0;k<4;k++)
+			{
+			for(j=0;j<loteMax;j++)
+				{
+				X->RK[i][k][j] = pl[k][0] ^ (k >= 2 ? 0xffff : 0);
+				}
+			}
+		}
+	return;
+	}
+
+/*
+ * Function: midoriLote()
+ *
+ * Purpose: Encrypts independent blocks with the selected batch kernel
+ *
+ * Parameters:
+ *   - llaveLote *X: Key planes from desempacaLote()
+ *   - bloques S: Plaintext blocks
+ *   - size_t t: Number of blocks (any; processed loteMax at a time)
+ *   - bloques Y: Output blocks (may alias S)
+ *
+ * Returns: void
+ *
+ * Details: Same result as midoriExp(S[i], L, 0) for every block. Only
+ *          the vectors that hold blocks are processed, so a partial
+ *          batch costs ceil(t / blocks per vector) vector passes.
+ */
+void midoriLote(llaveLote *X, bloques S, size_t t, bloques Y)
+	{
+	uint16_t pl[4][loteMax] __attribute__((aligned(32)));
+	size_t c;
+	size_t j;
+	size_t k;
+
+	memset(pl, 0, sizeof(pl));
+	for(c=0;c<t;c+=loteMax)
+		{
+		k = (t - c < loteMax) ? t - c : loteMax;
+		for(j=0;j<k;j++)
+			{
+			aPlanos(S[c+j], pl[0], j);
+			}
+		lotNuc[loteMot](X, pl[0], (k + lotCarr[loteMot] - 1) / lotCarr[loteMot]);
+		for(j=0;j<k;j++)
+			{
+			Y[c+j] = dePlanos(pl[0], j);
+			}
+		}
+	return;
+	}
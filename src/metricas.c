@@ -0,0 +1,377 @@
+/*
+ * ============================================================================
+ * File: metricas.c
+ * Purpose: Operation counters and latency histograms for COFB-Midori64
+ *
+ * This file implements:
+ * - Per-thread counters updated by the COFB encryption/decryption routines
+ * - A fixed-bucket latency histogram per operation type
+ * - Rendering of all counters in the Prometheus text exposition format
+ *
+ * Thread Model:
+ *   Each thread owns one counter block and updates it with plain loads
+ *   and relaxed stores, so worker threads never share a cache line or
+ *   run a read-modify-write. Blocks are linked in a list at first use and
+ *   summed only when the counters are rendered (metTotal()). A block
+ *   outlives its thread: when the thread exits it is marked free, keeps
+ *   its counts and is handed to the next new thread.
+ *
+ * Export Model:
+ *   The metrics are written to a file that is atomically replaced
+ *   (write to "<path>.tmp", then rename), which is the layout expected by
+ *   the node_exporter textfile collector.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"metricas.h"
+#include <pthread.h>
+
+/*
+ * Counter block of one thread, linked into metLista
+ */
+typedef struct MetNodoS{
+	metricas	 M;		//contadores del hilo
+	struct MetNodoS	*sig;		//siguiente bloque de la lista
+	byte		 libre;		//1 si su hilo termino y puede reutilizarse
+	} metNodo;
+
+static metNodo *metLista = NULL;			// Every block ever created
+static pthread_mutex_t metCand = PTHREAD_MUTEX_INITIALIZER;	// Guards metLista
+static pthread_key_t metClave;				// Frees a block at thread exit
+static pthread_once_t metUna = PTHREAD_ONCE_INIT;
+static __thread metNodo *metMio = NULL;			// Block of the calling thread
+
+/*
+ * Latency Bucket Limits
+ *
+ * Purpose: Upper bounds (in seconds) of the finite histogram buckets
+ * Size: nCub limits; an implicit +Inf bucket follows the last one
+ */
+const double limCub[nCub] = {
+	0.000001,	//1us
+	0.0000025,	//2.5us
+	0.000005,	//5us
+	0.00001,	//10us
+	0.000025,	//25us
+	0.00005,	//50us
+	0.0001,		//100us
+	0.00025,	//250us
+	0.001,		//1ms
+	0.01,		//10ms
+	0.1,		//100ms
+	1.0		//1s
+	};
+
+/*
+ * Operation labels used in the exposition output, indexed by opCif/opDes
+ */
+static const char * nomOp[nOps] = {"encrypt", "decrypt"};
+
+/*
+ * Function: metReloj()
+ *
+ * Purpose: Reads a monotonic clock for latency measurements
+ *
+ * Returns:
+ *   - double: Current monotonic time in seconds
+ */
+double metReloj()
+	{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+	}
+
+/*
+ * Function: metSuelta()
+ *
+ * Purpose: Thread exit destructor, marks the block of the thread free
+ */
+static void metSuelta(void *x)
+	{
+	pthread_mutex_lock(&metCand);
+	((metNodo *)x)->libre = 1;
+	pthread_mutex_unlock(&metCand);
+	return;
+	}
+
+/*
+ * Function: metClaveIni()
+ *
+ * Purpose: Creates the thread-exit key once per process
+ */
+static void metClaveIni()
+	{
+	pthread_key_create(&metClave, metSuelta);
+	return;
+	}
+
+/*
+ * Function: metPropias()
+ *
+ * Purpose: Counter block of the calling thread
+ *
+ * Returns:
+ *   - metricas *: Block owned by this thread until it exits
+ *
+ * Details: The first call of a thread takes a block freed by a finished
+ *          thread, or links a new one; the counts already in it stay
+ *          part of the totals
+ */
+metricas * metPropias()
+	{
+	metNodo *N;
+
+	if(metMio != NULL)
+		{
+		return(&metMio->M);
+		}
+	pthread_once(&metUna, metClaveIni);
+	pthread_mutex_lock(&metCand);
+	for(N=metLista;N!=NULL && N->libre==0;N=N->sig);
+	if(N == NULL)
+		{
+		N = calloc(1, sizeof(metNodo));
+		if(N == NULL)
+			{
+			fprintf(stderr,"Error al asignar memoria\n");
+			exit(1);
+			}
+		N->sig = metLista;
+		__atomic_store_n(&metLista, N, __ATOMIC_RELEASE);
+		}
+	N->libre = 0;
+	pthread_mutex_unlock(&metCand);
+	pthread_setspecific(metClave, N);
+	metMio = N;
+	return(&N->M);
+	}
+
+/*
+ * Function: suma()
+ *
+ * Purpose: Adds to a counter of the calling thread's block; only the
+ *          store is atomic, since no other thread writes it
+ */
+static inline void suma(uint64_t *x, uint64_t v)
+	{
+	__atomic_store_n(x, *x + v, __ATOMIC_RELAXED);
+	return;
+	}
+
+/*
+ * Function: metOp()
+ *
+ * Purpose: Records one completed operation
+ *
+ * Parameters:
+ *   - byte op: Operation type (opCif or opDes)
+ *   - double t0: Start time of the operation as returned by metReloj()
+ *   - uint64_t a: Number of associated data blocks processed
+ *   - uint64_t m: Number of message blocks processed
+ *
+ * Returns: void
+ *
+ * Details: Bucket counts are stored non-cumulatively and accumulated
+ *          only when rendered. The counts go to the calling thread's
+ *          block (metPropias())
+ */
+void metOp(byte op, double t0, uint64_t a, uint64_t m)
+	{
+	double lat = metReloj() - t0;	// Operation latency
+	metricas *M = metPropias();
+	byte i = 0;
+
+	// Locate first bucket whose limit contains the latency
+	while(i<nCub && lat>limCub[i])
+		{
+		i++;
+		}
+
+	// Only this thread writes M; metTotal() may read it concurrently
+	suma(&M->ops[op], 1);
+	suma(&M->bloqA[op], a);
+	suma(&M->bloqM[op], m);
+	suma(&M->cub[op][i], 1);
+	lat += M->sumLat[op];
+	__atomic_store(&M->sumLat[op], &lat, __ATOMIC_RELAXED);
+	return;
+	}
+
+/*
+ * Function: metFalla()
+ *
+ * Purpose: Records one decryption whose tag did not verify
+ */
+void metFalla()
+	{
+	metricas *M = metPropias();
+
+	suma(&M->fallas, 1);
+	return;
+	}
+
+/*
+ * Function: metTotal()
+ *
+ * Purpose: Sums the counter blocks of every thread
+ *
+ * Parameters:
+ *   - metricas *T: Totals (output)
+ *
+ * Returns: void
+ *
+ * Details: Counters still being updated by running threads are read
+ *          with relaxed loads, so each value is one the thread stored;
+ *          blocks are never unlinked, so the list can be walked without
+ *          the lock
+ */
+void metTotal(metricas *T)
+	{
+	metNodo *N;
+	double l;
+	byte o;
+	byte i;
+
+	memset(T, 0, sizeof(metricas));
+	for(N=__atomic_load_n(&metLista, __ATOMIC_ACQUIRE);N!=NULL;N=N->sig)
+		{
+		for(o=0;o<nOps;o++)
+			{
+			T->ops[o]	+= __atomic_load_n(&N->M.ops[o], __ATOMIC_RELAXED);
+			T->bloqA[o]	+= __atomic_load_n(&N->M.bloqA[o], __ATOMIC_RELAXED);
+			T->bloqM[o]	+= __atomic_load_n(&N->M.bloqM[o], __ATOMIC_RELAXED);
+			for(i=0;i<=nCub;i++)
+				{
+				T->cub[o][i] += __atomic_load_n(&N->M.cub[o][i], __ATOMIC_RELAXED);
+				}
+			__atomic_load(&N->M.sumLat[o], &l, __ATOMIC_RELAXED);
+			T->sumLat[o] += l;
+			}
+		T->fallas += __atomic_load_n(&N->M.fallas, __ATOMIC_RELAXED);
+		}
+	return;
+	}
+
+/*
+ * Function: metImpProm()
+ *
+ * Purpose: Writes every counter, summed over all threads, in Prometheus
+ *          text exposition format
+ *
+ * Parameters:
+ *   - FILE *f: Destination stream
+ *
+ * Returns: void
+ *
+ * Exported Series:
+ *   - cofb_operations_total{op}
+ *   - cofb_bytes_total{op,kind}        (kind = "ad" or "message")
+ *   - cofb_tag_failures_total
+ *   - cofb_operation_seconds{op}       (histogram)
+ */
+void metImpProm(FILE *f)
+	{
+	metricas met;
+	byte o;
+	byte i;
+	uint64_t acum;
+
+	metTotal(&met);
+
+	fprintf(f,"# HELP cofb_operations_total Completed COFB operations.\n");
+	fprintf(f,"# TYPE cofb_operations_total counter\n");
+	for(o=0;o<nOps;o++)
+		{
+		fprintf(f,"cofb_operations_total{op=\"%s\"} %" PRIu64 "\n",nomOp[o],met.ops[o]);
+		}
+
+	fprintf(f,"# HELP cofb_bytes_total Bytes processed by COFB operations.\n");
+	fprintf(f,"# TYPE cofb_bytes_total counter\n");
+	for(o=0;o<nOps;o++)
+		{
+		fprintf(f,"cofb_bytes_total{op=\"%s\",kind=\"ad\"} %" PRIu64 "\n",nomOp[o],met.bloqA[o]*n_8);
+		fprintf(f,"cofb_bytes_total{op=\"%s\",kind=\"message\"} %" PRIu64 "\n",nomOp[o],met.bloqM[o]*n_8);
+		}
+
+	fprintf(f,"# HELP cofb_tag_failures_total Decryptions whose tag did not verify.\n");
+	fprintf(f,"# TYPE cofb_tag_failures_total counter\n");
+	fprintf(f,"cofb_tag_failures_total %" PRIu64 "\n",met.fallas);
+
+	fprintf(f,"# HELP cofb_operation_seconds Latency of COFB operations.\n");
+	fprintf(f,"# TYPE cofb_operation_seconds histogram\n");
+	for(o=0;o<nOps;o++)
+		{
+		acum = 0;
+		// Prometheus buckets are cumulative
+		for(i=0;i<nCub;i++)
+			{
+			acum += met.cub[o][i];
+			fprintf(f,"cofb_operation_seconds_bucket{op=\"%s\",le=\"%g\"} %" PRIu64 "\n",nomOp[o],limCub[i],acum);
+			}
+		acum += met.cub[o][nCub];
+		fprintf(f,"cofb_operation_seconds_bucket{op=\"%s\",le=\"+Inf\"} %" PRIu64 "\n",nomOp[o],acum);
+		fprintf(f,"cofb_operation_seconds_sum{op=\"%s\"} %.9f\n",nomOp[o],met.sumLat[o]);
+		fprintf(f,"cofb_operation_seconds_count{op=\"%s\"} %" PRIu64 "\n",nomOp[o],acum);
+		}
+	return;
+	}
+
+/*
+ * Function: metEscribir()
+ *
+ * Purpose: Atomically replaces a metrics file with the current counters
+ *
+ * Parameters:
+ *   - cad ruta: Path of the metrics file ("-" writes to stdout)
+ *
+ * Returns:
+ *   - 0: File written successfully
+ *   - 1: File could not be written
+ *
+ * Details: The temporary file lives in the same directory so that
+ *          rename() is atomic and scrapers never read a partial file
+ */
+byte metEscribir(cad ruta)
+	{
+	FILE *f;
+	byte err;
+	cad tmp;
+
+	if(strcmp(ruta,"-")==0)
+		{
+		metImpProm(stdout);
+		return(0);
+		}
+
+	tmp = malloc(strlen(ruta) + 5);
+	if(tmp==NULL)
+		{
+		return(1);
+		}
+	sprintf(tmp,"%s.tmp",ruta);
+
+	f = fopen(tmp,"w");
+	if(f==NULL)
+		{
+		free(tmp);
+		return(1);
+		}
+	metImpProm(f);
+	err = (fclose(f)!=0);
+
+	if(err==0 && rename(tmp,ruta)!=0)
+		{
+		err = 1;
+		}
+	if(err!=0)
+		{
+		remove(tmp);
+		}
+	free(tmp);
+	return(err);
+	}
@@ -51,6 +51,29 @@ const dbyte  beta[0x10] = {
 	0x7c81	//f
 	};
 
+/*
+ * betaNib: beta[0] to beta[e] spread one bit per nibble (bit 15-j of
+ *          beta[i] in the low bit of nibble j), ready to XOR into a round
+ *          key in one step
+ */
+static const bloque betaNib[r-1] = {
+	0x0001010110110011,	//0
+	0x0111100011000000,	//1
+	0x1010010000110101,	//2
+	0x0110001000010011,	//3
+	0x0001000001001111,	//4
+	0x1101000101110000,	//5
+	0x0000001001100110,	//6
+	0x0000101111001100,	//7
+	0x1001010010000001,	//8
+	0x0100000010111000,	//9
+	0x0111000110010111,	//a
+	0x0010001010001110,	//b
+	0x0101000100110000,	//c
+	0x1111100011001010,	//d
+	0x1101111110010000	//e
+	};
+
 /*****************************************************************************
  * NIBBLE EXTRACTION AND ASSIGNMENT FUNCTIONS
  * 
@@ -144,31 +167,22 @@ bloque asgNibble(bloque S, nibble pos, nibble val)
  * Details:
  *   - Alternates between Ki[0] and Ki[1] using (i & 0x1)
  *   - Beta values provide round constants for variety
+ *   - The beta bits come pre-spread from betaNib, so a round key costs
+ *     one XOR instead of 16 nibble extractions and insertions
  */
 bloque keyGen(bloque RK[r], bloque Ki[2])
 	{
 	nibble i;
-	nibble j;
-	nibble bit;
-	nibble val;
 	bloque WK;
 	
 	// Whitening key is XOR of both key blocks
 	WK = Ki[0] ^ Ki[1];
 	
-	// Generate round keys for all 15 rounds
+	// Generate round keys for all 15 rounds: each nibble of the
+	// alternating key block gets its beta bit in one XOR (betaNib)
 	for(i=0;i<=r-2;i++)
 		{
-		// For each nibble in the key
-		for(j=0;j<nxn;j++)
-			{
-			// Extract beta bit for this position
-			bit = (beta[i] >> (nxn-j-1)) & 0x1;
-			// Extract nibble from alternating key block
-			val = obtNibble(Ki[i & 0x1],j);
-			// Assign XORed value to round key
-			RK[i] = asgNibble(RK[i],j,val^bit);
-			}
+		RK[i] = Ki[i & 0x1] ^ betaNib[i];
 		}
 
 	return(WK);
@@ -350,6 +364,48 @@ bloque mixColumn(bloque S)
  * Core encryption algorithm implementing the Midori-64 cipher
  *****************************************************************************/
 
+/*
+ * Function: expandeLlave()
+ * 
+ * Purpose: Runs the key schedule once for repeated use
+ * 
+ * Parameters:
+ *   - llaveExp *L: Expanded key (output)
+ *   - bloque Ki[2]: Master key split into 2 blocks of 64-bits each
+ * 
+ * Returns: void
+ * 
+ * Details: The unused last round key slot is zeroed, so expanded keys
+ *          can be compared or stored byte for byte
+ */
+void expandeLlave(llaveExp *L, bloque Ki[2])
+	{
+	memset(L, 0, sizeof(llaveExp));
+	L->WK = keyGen(L->RK, Ki);
+	return;
+	}
+
+/*
+ * Function: midoriTablas()
+ * 
+ * Purpose: Reports the lookup table read by the key schedule
+ * 
+ * Parameters:
+ *   - size_t *t: Size of the table in bytes (output)
+ * 
+ * Returns:
+ *   - const void *: Start of betaNib
+ * 
+ * Details: Sb0 and shuffleP are immediates, so betaNib is the only
+ *          table of this file touched when a key is expanded; cold-cache
+ *          benchmarks flush it together with the kernel tables
+ */
+const void * midoriTablas(size_t *t)
+	{
+	*t = sizeof(betaNib);
+	return(betaNib);
+	}
+
 /*
  * Function: midori()
  * 
@@ -363,34 +419,54 @@ bloque mixColumn(bloque S)
  * Returns:
  *   - bloque: Ciphertext/output block
  * 
+ * Details: Expands the key on every call; callers that encrypt many
+ *          blocks under one key should use expandeLlave() and
+ *          midoriExp() instead
+ */
+bloque midori(bloque S, bloque Ki[2], byte inv)
+	{
+	llaveExp L;
+	
+	// Generate round keys from master key
+	expandeLlave(&L,Ki);
+	return(midoriExp(S,&L,inv));
+	}
+
+/*
+ * Function: midoriExp()
+ * 
+ * Purpose: Executes Midori-64 with an already expanded key
+ * 
+ * Parameters:
+ *   - bloque S: Input block (plaintext or state)
+ *   - llaveExp *L: Key expanded by expandeLlave()
+ *   - byte inv: Operation mode (0=encryption, non-zero=other modes)
+ * 
+ * Returns:
+ *   - bloque: Ciphertext/output block
+ * 
  * Algorithm Structure:
- *   1. Generate round keys from Ki
- *   2. Initial key addition (whitening): S ⊕ WK
- *   3. Perform 15 rounds, each containing:
+ *   1. Initial key addition (whitening): S ⊕ WK
+ *   2. Perform 15 rounds, each containing:
  *      - SubCell: S-box substitution
  *      - ShuffleCell: Permutation
  *      - MixColumns: Diffusion
  *      - Key addition: S ⊕ RK[round]
- *   4. Final SubCell substitution
- *   5. Final whitening: S ⊕ WK
+ *   3. Final SubCell substitution
+ *   4. Final whitening: S ⊕ WK
  * 
  * Details:
  *   - 16 total rounds (rounds 0-15, where round 15 is final)
  *   - Branch on inv parameter (currently single path)
  *   - Each round operates on full 64-bit state (16 nibbles)
  */
-bloque midori(bloque S, bloque Ki[2], byte inv)
+bloque midoriExp(bloque S, llaveExp *L, byte inv)
 	{
 	nibble i;
 	bloque Y;
-	bloque WK;
-	bloque RK[r];
-	
-	// Generate round keys from master key
-	WK = keyGen(RK,Ki);
 	
 	// Initial key addition (whitening)
-	S = keyAdd(S,WK);
+	S = keyAdd(S,L->WK);
 
 	// 15 main rounds (0 to 14)
 	for(i=0;i<=r-2;i++)
@@ -403,14 +479,14 @@ bloque midori(bloque S, bloque Ki[2], byte inv)
 		S = (inv == 0) ? mixColumn(S)      : shuffleCell(S,-1);
 		
 		// Add round key
-		S = keyAdd(S,RK[i]);
+		S = keyAdd(S,L->RK[i]);
 		}
 
 	// Final round
 	S = subCell(S);
 	
 	// Final whitening with initial key
-	Y = keyAdd(S,WK);
+	Y = keyAdd(S,L->WK);
 	
 	return(Y);
 	}
@@ -159,32 +159,64 @@ tn2 leeBin(cad a)
  * Returns:
  *   - bloque: Byte-reversed version of input
  * 
- * Algorithm:
- *   1. Iterates 8 times (for each byte)
- *   2. Each iteration:
- *      - Left-shifts accumulated result by 8 bits
- *      - Extracts one byte from input via 8 right-shifts
- *      - XORs with accumulated result
- *   3. Result: Original byte order inverted (endianness reversal)
+ * Details: A single bswap instruction on x86-64
  * 
  * Example: 0x0102030405060708 → 0x0807060504030201
  */
 bloque reverse(bloque a)
 	{
-	bloque b=0x0;				// Accumulator for reversed value
-	bloque desp;				// Displacement/shift value
-	byte i;						// Loop counter
-	
-	// Extract each byte and accumulate in reverse order
-	for(i=0;i<0x08;i++)
+	return(__builtin_bswap64(a));
+	}
+
+/*
+ * Function: cargaBEs()
+ * 
+ * Purpose: Loads big-endian bytes into blocks
+ * 
+ * Parameters:
+ *   - const byte *p: Source (8 bytes per block)
+ *   - bloques B: Destination blocks
+ *   - size_t m: Number of blocks
+ * 
+ * Returns: void
+ * 
+ * Details: Batch form of cargaBE() for the buffer, stream and file
+ *          paths. The iterations are independent, so the compiler may
+ *          turn the loop into vector byte shuffles; SIMD engines can
+ *          instead fold the swap into their own transposes.
+ */
+void cargaBEs(const byte *p, bloques B, size_t m)
+	{
+	size_t i;
+
+	for(i=0;i<m;i++)
 		{
-		desp = i;
-		// Right-shift by (i*8) bits to extract i-th byte
-		// Perform 8 right-shifts of desp value (shifts by 8*desp)
-		b = (bloque)(b<<0x08) ^((((((((a >> desp) >> desp) >> desp) >> desp) >> desp) >> desp) >> desp) >> desp) &0xff;
+		B[i] = cargaBE(p + i * sizeof(bloque));
 		}
-	
-	return(b);
+	return;
+	}
+
+/*
+ * Function: guardaBEs()
+ * 
+ * Purpose: Stores blocks as big-endian bytes
+ * 
+ * Parameters:
+ *   - bloques B: Source blocks
+ *   - byte *p: Destination (8 bytes per block)
+ *   - size_t m: Number of blocks
+ * 
+ * Returns: void
+ */
+void guardaBEs(bloques B, byte *p, size_t m)
+	{
+	size_t i;
+
+	for(i=0;i<m;i++)
+		{
+		guardaBE(p + i * sizeof(bloque), B[i]);
+		}
+	return;
 	}
 
 /*
@@ -216,3 +248,27 @@ byte hayNL(cad a)
 		}
 	return(0);				// No newline found
 	}
+
+/*
+ * Function: aleat()
+ * 
+ * Purpose: Fast seeded pseudo-random generator (SplitMix64)
+ * 
+ * Parameters:
+ *   - bloque *edo: Generator state, advanced on every call
+ * 
+ * Returns:
+ *   - bloque: Next 64-bit pseudo-random value
+ * 
+ * Details:
+ *   - Deterministic for a given seed; NOT suitable for keys or nonces
+ *   - Used to synthesize workloads and test data reproducibly
+ */
+bloque aleat(bloque *edo)
+	{
+	bloque z = (*edo += 0x9e3779b97f4a7c15);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return(z ^ (z >> 31));
+	}
@@ -0,0 +1,200 @@
+/*
+ * ============================================================================
+ * File: nonces.c
+ * Purpose: Nonce allocation for many threads encrypting under one key
+ *
+ * A single atomic counter shared by every thread turns each nonce into a
+ * cache-line transfer between cores. Here the counter only hands out
+ * leases of nonTrozo consecutive nonces; each thread then numbers its
+ * messages from its own lease without touching shared memory.
+ *
+ * Persistence:
+ *   With a state file, the highest nonce that may have been handed out
+ *   (the high-water mark) is written and synced before any nonce at or
+ *   above the previous mark is used. A restarted process resumes at the
+ *   mark, so no nonce is reused even after a crash; the unused rest of
+ *   the leases is skipped. The mark advances nonAvance nonces at a time,
+ *   so the file is written once every nonAvance / nonTrozo leases.
+ *
+ * State File (16 bytes, big-endian):
+ *   "CFBN" | version (1) | reserved (3) | high-water mark (8)
+ *
+ * One state file must be used per key, and no two processes may share
+ * it at the same time.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"nonces.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Function: nonGuarda()
+ *
+ * Purpose: Writes and syncs a new high-water mark
+ */
+static byte nonGuarda(gestorN *G, uint64_t v)
+	{
+	byte b[nonCab];
+
+	memset(b, 0, nonCab);
+	memcpy(b, nonMagia, 4);
+	b[4] = nonVer;
+	guardaBE(b + n_8, v);
+	return(escTodoEn(G->fd, b, nonCab, 0) || fdatasync(G->fd) != 0);
+	}
+
+/*
+ * Function: nonAbre()
+ *
+ * Purpose: Starts a nonce manager
+ *
+ * Parameters:
+ *   - gestorN *G: Manager (output)
+ *   - cad ruta: State file, created if missing; NULL for no persistence
+ *   - uint64_t ini: First nonce without a state file (e.g. random)
+ *   - uint64_t lim: End of the nonce space, exclusive
+ *
+ * Returns:
+ *   - 0: Ready
+ *   - 1: State file unreadable, malformed or not writable
+ *
+ * Details: A new state file starts at nonce 0
+ */
+byte nonAbre(gestorN *G, cad ruta, uint64_t ini, uint64_t lim)
+	{
+	byte b[nonCab];
+	size_t l;
+
+	memset(G, 0, sizeof(gestorN));
+	G->lim	= lim;
+	G->fd	= -1;
+	G->sig	= ini;
+	G->tope	= lim;
+	pthread_mutex_init(&G->m, NULL);
+	if(ruta == NULL)
+		{
+		return(0);
+		}
+	if((G->fd = open(ruta, O_RDWR | O_CREAT, 0600)) < 0)
+		{
+		return(1);
+		}
+	l = leeTodo(G->fd, b, nonCab);
+	if(l == 0)
+		{
+		G->sig = 0;
+		}
+	else if(l != nonCab || memcmp(b, nonMagia, 4) != 0 || b[4] != nonVer)
+		{
+		return(1);
+		}
+	else
+		{
+		G->sig = cargaBE(b + n_8);
+		}
+	// Nothing at or above the mark may be used before it is raised
+	G->tope = G->sig;
+	return(G->sig > lim);
+	}
+
+/*
+ * Function: nonCierra()
+ *
+ * Purpose: Releases a nonce manager
+ */
+void nonCierra(gestorN *G)
+	{
+	if(G->fd >= 0)
+		{
+		close(G->fd);
+		G->fd = -1;
+		}
+	pthread_mutex_destroy(&G->m);
+	return;
+	}
+
+/*
+ * Function: nonIniArr()
+ *
+ * Purpose: Starts an empty lease; each thread owns its own
+ */
+void nonIniArr(arriendo *R, gestorN *G)
+	{
+	R->G	= G;
+	R->a	= 0;
+	R->b	= 0;
+	return;
+	}
+
+/*
+ * Function: nonArrienda()
+ *
+ * Purpose: Takes a new lease from the shared counter
+ *
+ * Returns:
+ *   - 0: Lease [R->a, R->b) ready
+ *   - 1: Nonce space exhausted or state file not written
+ */
+static byte nonArrienda(arriendo *R, uint64_t k)
+	{
+	gestorN *G = R->G;
+	uint64_t t = k > nonTrozo ? k : nonTrozo;
+	uint64_t a = __atomic_fetch_add(&G->sig, t, __ATOMIC_RELAXED);
+	uint64_t v;
+	byte err = 0;
+
+	if(t > G->lim || a > G->lim - t)
+		{
+		return(1);
+		}
+	if(a + t > __atomic_load_n(&G->tope, __ATOMIC_ACQUIRE))
+		{
+		pthread_mutex_lock(&G->m);
+		if(a + t > G->tope)
+			{
+			v = G->lim - (a + t) > nonAvance ? a + t + nonAvance : G->lim;
+			err = nonGuarda(G, v);
+			if(err == 0)
+				{
+				__atomic_store_n(&G->tope, v, __ATOMIC_RELEASE);
+				}
+			}
+		pthread_mutex_unlock(&G->m);
+		}
+	if(err != 0)
+		{
+		return(1);
+		}
+	R->a	= a;
+	R->b	= a + t;
+	return(0);
+	}
+
+/*
+ * Function: nonPide()
+ *
+ * Purpose: Assigns consecutive nonces from a thread's lease
+ *
+ * Parameters:
+ *   - arriendo *R: Lease of the calling thread
+ *   - uint64_t k: Nonces wanted (e.g. segments of a container)
+ *   - bloque *N: First assigned nonce (output)
+ *
+ * Returns:
+ *   - 0: Nonces N .. N + k - 1 are this caller's alone
+ *   - 1: Nonce space exhausted or state file not written
+ */
+byte nonPide(arriendo *R, uint64_t k, bloque *N)
+	{
+	if(k > R->b - R->a && nonArrienda(R, k) != 0)
+		{
+		return(1);
+		}
+	*N = R->a;
+	R->a += k;
+	return(0);
+	}
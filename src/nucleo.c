@@ -0,0 +1,306 @@
+/*
+ * ============================================================================
+ * File: nucleo.c
+ * Purpose: Single-block Midori-64 kernel for the sequential COFB chain
+ *
+ * Every COFB block depends on the cipher output of the previous one, so
+ * the chain is bound by the latency of one Midori call, not by how many
+ * blocks a kernel can keep in flight. This kernel holds one state in an
+ * XMM register with one nibble per byte lane (lane i = nibble i, nibble 0
+ * being the most significant one, as in obtNibble()):
+ *
+ *   - SubCell:               one pshufb into the 16-entry S-box
+ *   - ShuffleCell+MixColumn: three pshufb with the permutation composed
+ *                            with the in-column rotations by 1, 2 and 3,
+ *                            then two XORs (a column of MixColumn is four
+ *                            consecutive lanes, out_j = x_j^1 ^ x_j^2 ^
+ *                            x_j^3, see mixColumn())
+ *   - KeyAdd:                one XOR with a pre-unpacked round key
+ *
+ * The three shuffles are independent, so a round costs about five
+ * dependent instructions. Unpacking and packing the 64-bit block happens
+ * once per call, and the round keys are unpacked once per operation by
+ * desempacaLlave().
+ *
+ * Engines:
+ *   - motRef: midoriExp() from midori.c
+ *   - motNib: this kernel (SSSE3, detected at run time on x86); on other
+ *             targets a portable byte-lane version of the same steps
+ *
+ * Only the forward cipher is provided: COFB never runs Midori backwards.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"nucleo.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define nucX86
+#endif
+
+/*
+ * Engine Selection
+ *
+ * nucMot: Engine used by new COFB operations; set by nucIni() to the
+ *         fastest engine this CPU supports, benchmarks may override it
+ * nomMot: Engine labels used in reports, indexed by motRef/motNib
+ */
+byte nucMot = motRef;
+const char * nomMot[nMot] = {"ref", "ssse3"};
+
+/*
+ * Tables of the byte-lane kernel
+ *
+ * tSb: Midori Sb0 (the nibbles of Sb0 in midori.h)
+ * tP1, tP2, tP3: shuffleP composed with the column rotations,
+ *                tPk[i] = shuffleP[i ^ k]
+ */
+static const byte tSb[nxn] __attribute__((aligned(16))) =
+	{0xc,0xa,0xd,0x3,0xe,0xb,0xf,0x7,0x8,0x9,0x1,0x5,0x0,0x2,0x4,0x6};
+static const byte tP1[nxn] __attribute__((aligned(16))) =
+	{0xa,0x0,0xf,0x5,0x4,0xe,0x1,0xb,0x3,0x9,0x6,0xc,0xd,0x7,0x8,0x2};
+static const byte tP2[nxn] __attribute__((aligned(16))) =
+	{0x5,0xf,0x0,0xa,0xb,0x1,0xe,0x4,0xc,0x6,0x9,0x3,0x2,0x8,0x7,0xd};
+static const byte tP3[nxn] __attribute__((aligned(16))) =
+	{0xf,0x5,0xa,0x0,0x1,0xb,0x4,0xe,0x6,0xc,0x3,0x9,0x8,0x2,0xd,0x7};
+
+/*
+ * Function: hayMot()
+ *
+ * Purpose: Tells whether an engine can run on this CPU
+ *
+ * Parameters:
+ *   - byte mot: motRef or motNib
+ *
+ * Returns:
+ *   - 1: Engine available
+ *   - 0: Engine unknown or not supported
+ */
+byte hayMot(byte mot)
+	{
+	switch(mot)
+		{
+		case motRef:
+			return(1);
+		case motNib:
+#ifdef nucX86
+			return(__builtin_cpu_supports("ssse3") != 0);
+#else
+			return(1);
+#endif
+		}
+	return(0);
+	}
+
+/*
+ * Function: nucTablas()
+ *
+ * Purpose: Lists the lookup tables read by a single-block COFB operation
+ *
+ * Parameters:
+ *   - const void *p[maxTab]: Start of each table (output)
+ *   - size_t t[maxTab]: Size of each table in bytes (output)
+ *
+ * Returns:
+ *   - byte: Number of tables
+ *
+ * Details: betaNib of the key schedule (midoriTablas()) plus tSb and
+ *          tP1 to tP3 of this kernel; the reference engine has no other
+ *          tables. Used by cold-cache benchmarks to evict them
+ */
+byte nucTablas(const void *p[maxTab], size_t t[maxTab])
+	{
+	p[0] = midoriTablas(&t[0]);
+	p[1] = tSb;
+	p[2] = tP1;
+	p[3] = tP2;
+	p[4] = tP3;
+	t[1] = sizeof(tSb);
+	t[2] = sizeof(tP1);
+	t[3] = sizeof(tP2);
+	t[4] = sizeof(tP3);
+	return(maxTab);
+	}
+
+/*
+ * Function: nucIni()
+ *
+ * Purpose: Selects the default engine before main() runs
+ *
+ * Details: Running as a constructor keeps the choice fixed before any
+ *          worker thread reads nucMot
+ */
+static void __attribute__((constructor)) nucIni()
+	{
+	nucMot = hayMot(motNib) ? motNib : motRef;
+	return;
+	}
+
+#ifdef nucX86
+
+/*
+ * Function: nibLanes()
+ *
+ * Purpose: Spreads the 16 nibbles of a block over 16 byte lanes
+ *
+ * Parameters:
+ *   - bloque S: Block (nibble 0 in the most significant bits)
+ *
+ * Returns:
+ *   - __m128i: Lane i holds nibble i
+ *
+ * Details: SSE2 only; after the byte swap, byte k holds nibbles 2k
+ *          (high half) and 2k+1 (low half)
+ */
+static inline __m128i nibLanes(bloque S)
+	{
+	__m128i v = _mm_cvtsi64_si128((long long)__builtin_bswap64(S));
+	__m128i m = _mm_set1_epi8(0x0f);
+
+	return(_mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(v, 4), m), _mm_and_si128(v, m)));
+	}
+
+/*
+ * Function: lanesNib()
+ *
+ * Purpose: Packs 16 byte lanes back into a block (inverse of nibLanes())
+ *
+ * Details: pmaddubsw computes 16 * lane[2k] + lane[2k+1] per 16-bit word,
+ *          packuswb narrows the words to bytes
+ */
+static inline __attribute__((target("ssse3"))) bloque lanesNib(__m128i x)
+	{
+	x = _mm_maddubs_epi16(x, _mm_set1_epi16(0x0110));
+	return(__builtin_bswap64((bloque)_mm_cvtsi128_si64(_mm_packus_epi16(x, x))));
+	}
+
+/*
+ * Function: desempacaLlave()
+ *
+ * Purpose: Unpacks an expanded key for midoriNib()
+ *
+ * Parameters:
+ *   - llaveNib *X: Unpacked key (output)
+ *   - llaveExp *L: Key expanded by expandeLlave()
+ *
+ * Returns: void
+ *
+ * Details: Costs a few instructions per round key, so it is done once
+ *          per COFB operation instead of keeping both forms in llaveExp
+ *          (whose size is part of the key store format)
+ */
+void desempacaLlave(llaveNib *X, llaveExp *L)
+	{
+	byte i;
+
+	_mm_store_si128((__m128i *)X->WK, nibLanes(L->WK));
+	for(i=0;i<r;i++)
+		{
+		_mm_store_si128((__m128i *)X->RK[i], nibLanes(L->RK[i]));
+		}
+	return;
+	}
+
+/*
+ * Function: midoriNib()
+ *
+ * Purpose: Encrypts one block with the byte-lane kernel
+ *
+ * Parameters:
+ *   - bloque S: Plaintext block
+ *   - llaveNib *X: Key unpacked by desempacaLlave()
+ *
+ * Returns:
+ *   - bloque: Same result as midoriExp(S, L, 0)
+ *
+ * Details: Callers must check hayMot(motNib) first
+ */
+__attribute__((target("ssse3"))) bloque midoriNib(bloque S, llaveNib *X)
+	{
+	byte i;
+	__m128i sb = _mm_load_si128((const __m128i *)tSb);
+	__m128i p1 = _mm_load_si128((const __m128i *)tP1);
+	__m128i p2 = _mm_load_si128((const __m128i *)tP2);
+	__m128i p3 = _mm_load_si128((const __m128i *)tP3);
+	__m128i wk = _mm_load_si128((const __m128i *)X->WK);
+	__m128i x;
+
+	// Initial key addition (whitening)
+	x = _mm_xor_si128(nibLanes(S), wk);
+
+	// 15 rounds: SubCell, then ShuffleCell and MixColumn fused, KeyAdd
+	for(i=0;i<=r-2;i++)
+		{
+		x = _mm_shuffle_epi8(sb, x);
+		x = _mm_xor_si128(_mm_xor_si128(_mm_shuffle_epi8(x, p1), _mm_shuffle_epi8(x, p2)),
+			_mm_xor_si128(_mm_shuffle_epi8(x, p3), _mm_load_si128((const __m128i *)X->RK[i])));
+		}
+
+	// Final round and whitening
+	x = _mm_xor_si128(_mm_shuffle_epi8(sb, x), wk);
+	return(lanesNib(x));
+	}
+
+#else
+
+/*
+ * Function: desempacaLlave()
+ *
+ * Purpose: Unpacks an expanded key for midoriNib() (portable version)
+ */
+void desempacaLlave(llaveNib *X, llaveExp *L)
+	{
+	byte i;
+	byte j;
+
+	for(j=0;j<nxn;j++)
+		{
+		X->WK[j] = obtNibble(L->WK, j);
+		for(i=0;i<r;i++)
+			{
+			X->RK[i][j] = obtNibble(L->RK[i], j);
+			}
+		}
+	return;
+	}
+
+/*
+ * Function: midoriNib()
+ *
+ * Purpose: Byte-lane kernel without SIMD, for targets other than x86
+ *
+ * Details: Same table steps as the SSSE3 version, one lane at a time
+ */
+bloque midoriNib(bloque S, llaveNib *X)
+	{
+	byte i;
+	byte j;
+	byte x[nxn];
+	byte z[nxn];
+	bloque Y = 0;
+
+	for(j=0;j<nxn;j++)
+		{
+		x[j] = obtNibble(S, j) ^ X->WK[j];
+		}
+	for(i=0;i<=r-2;i++)
+		{
+		for(j=0;j<nxn;j++)
+			{
+			z[j] = tSb[x[j]];
+			}
+		for(j=0;j<nxn;j++)
+			{
+			x[j] = z[tP1[j]] ^ z[tP2[j]] ^ z[tP3[j]] ^ X->RK[i][j];
+			}
+		}
+	for(j=0;j<nxn;j++)
+		{
+		Y = (Y << 4) | (tSb[x[j]] ^ X->WK[j]);
+		}
+	return(Y);
+	}
+
+#endif
@@ -0,0 +1,1165 @@
+/*
+ * ============================================================================
+ * File: paralelo.c
+ * Purpose: Parallel encryption, decryption and re-keying of many files
+ *
+ * Invoked as "cifrador enc|dec|rec [options] PATH...". Every input becomes
+ * a segmented container (see contenedor.c) named PATH.cfb, or is restored
+ * from one. A single process handles millions of files, avoiding one
+ * process start and one stdio stream per file.
+ *
+ * Re-keying (rec) moves containers to a new key in place: every record
+ * is decrypted under the old key and encrypted under the new one in the
+ * same pass (ctnRecifraSeg()), into PATH.cfb.tmp, with a base nonce
+ * leased for the new key exactly as enc would. The temporary file is
+ * synced and renamed over the container only once every old tag has
+ * verified, so a failure leaves the original untouched.
+ *
+ * Updating (act) writes a byte range into an existing container in place.
+ * Only the segments overlapping the range are decrypted, merged and
+ * encrypted again, in parallel, each under its next write counter (see
+ * parActualiza()). A container only owns the nonces of the segments it
+ * was created with, so segments added by an update take nonces from a
+ * run leased for them alone; the existing records stay where they are.
+ *
+ * Work Distribution:
+ *   - Small files (up to parLoteTam bytes) are grouped in batches of up
+ *     to parLoteMax files; a worker reads, encrypts and writes a whole
+ *     batch without touching shared state
+ *   - Large files are opened and sized up front, then split into tasks
+ *     of parSegTarea segments processed with pread()/pwrite() or through
+ *     a shared output mapping
+ *   - Workers claim tasks from one atomic counter, so files of very
+ *     different sizes still balance across the pool
+ *
+ * Outputs are created with O_EXCL (unless -f) and mode 0600. A file that
+ * fails, including any segment that does not verify on decryption, has
+ * its output removed.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"paralelo.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Growable file list filled while walking the arguments
+ */
+typedef struct ListaS{
+	arch	*F;
+	size_t	 num;
+	size_t	 cap;
+	} lista;
+
+/*
+ * Per-worker scratch buffers, grown on demand
+ */
+typedef struct BufS{
+	bytes	 e;		//entrada
+	bytes	 s;		//salida
+	bytes	 B;		//bloques de trabajo
+	size_t	 tE;
+	size_t	 tS;
+	size_t	 tB;
+	arriendo R;		//nonces del hilo
+	} bufs;
+
+/*
+ * Function: crece()
+ *
+ * Purpose: Ensures a scratch buffer holds at least t bytes
+ */
+static bytes crece(bytes p, size_t *cap, size_t t)
+	{
+	if(t > *cap)
+		{
+		p = realloc(p, t);
+		if(p == NULL)
+			{
+			fprintf(stderr,"Error al asignar memoria\n");
+			exit(1);
+			}
+		*cap = t;
+		}
+	return(p);
+	}
+
+/*
+ * Function: terminaEn()
+ *
+ * Purpose: Tests whether a path ends with a suffix
+ */
+static byte terminaEn(cad s, cad suf)
+	{
+	size_t l = strlen(s);
+	size_t t = strlen(suf);
+
+	return(l > t && strcmp(s + l - t, suf) == 0);
+	}
+
+/*
+ * Function: leeLlave()
+ *
+ * Purpose: Reads a 128-bit key stored as 32 hex digits
+ *
+ * Parameters:
+ *   - cad ruta: Key file
+ *   - bloques K: Key (2 blocks, output)
+ *
+ * Returns:
+ *   - 0: Key read
+ *   - 1: Missing file or malformed key
+ *
+ * Details: Keys are read from a file rather than the command line so
+ *          they never show up in the process list
+ */
+byte leeLlave(cad ruta, bloques K)
+	{
+	FILE *f = fopen(ruta, "r");
+	byte err;
+
+	if(f == NULL)
+		{
+		return(1);
+		}
+	err = fscanf(f, "%16" SCNx64 "%16" SCNx64, &K[0], &K[1]) != 2;
+	fclose(f);
+	return(err);
+	}
+
+/*
+ * Function: agrega()
+ *
+ * Purpose: Appends a file and its output path to the list
+ */
+static void agrega(lista *Li, cad e, uint64_t tam, byte op)
+	{
+	arch *F;
+	size_t l = strlen(e);
+
+	if(Li->num == Li->cap)
+		{
+		Li->cap = Li->cap ? Li->cap << 1 : 0x100;
+		Li->F = realloc(Li->F, Li->cap * sizeof(arch));
+		if(Li->F == NULL)
+			{
+			fprintf(stderr,"Error al asignar memoria\n");
+			exit(1);
+			}
+		}
+	F = &Li->F[Li->num++];
+	memset(F, 0, sizeof(arch));
+	F->e	= strdup(e);
+	F->s	= malloc(l + sizeof(parExt) + sizeof(parTmp));
+	F->tam	= tam;
+	F->fdE	= -1;
+	F->fdS	= -1;
+	if(F->e == NULL || F->s == NULL)
+		{
+		fprintf(stderr,"Error al asignar memoria\n");
+		exit(1);
+		}
+	if(op == opCif)
+		{
+		sprintf(F->s, "%s%s", e, parExt);
+		}
+	else if(op == parRec)
+		{
+		sprintf(F->s, "%s%s", e, parTmp);
+		}
+	else
+		{
+		memcpy(F->s, e, l - (sizeof(parExt) - 1));
+		F->s[l - (sizeof(parExt) - 1)] = 0;
+		}
+	return;
+	}
+
+/*
+ * Function: recorre()
+ *
+ * Purpose: Adds a path to the list, descending into directories
+ *
+ * Parameters:
+ *   - lista *Li: File list
+ *   - cad ruta: File or directory
+ *   - byte op: opCif (skips *.cfb), opDes or parRec (only *.cfb)
+ *   - byte rec: 1 if directories may be walked (-r)
+ *   - byte arg: 1 for command line arguments, 0 inside a directory
+ *
+ * Returns:
+ *   - 0: Path added or deliberately skipped
+ *   - 1: Unusable argument (reported)
+ *
+ * Details: Symbolic links met while walking are not followed
+ */
+static byte recorre(lista *Li, cad ruta, byte op, byte rec, byte arg)
+	{
+	struct stat st;
+	DIR *d;
+	struct dirent *x;
+	char *sub;
+	byte err = 0;
+
+	if((arg ? stat(ruta, &st) : lstat(ruta, &st)) != 0)
+		{
+		fprintf(stderr,"No se puede leer %s\n", ruta);
+		return(1);
+		}
+	if(S_ISREG(st.st_mode))
+		{
+		if((op != opCif) != terminaEn(ruta, parExt))
+			{
+			if(arg != 0)
+				{
+				fprintf(stderr,"%s: %s\n", ruta, op != opCif ? "no es un contenedor " parExt : "ya es un contenedor");
+				}
+			return(arg);
+			}
+		agrega(Li, ruta, (uint64_t)st.st_size, op);
+		return(0);
+		}
+	if(!S_ISDIR(st.st_mode))
+		{
+		return(0);
+		}
+	if(rec == 0)
+		{
+		fprintf(stderr,"%s es un directorio (use -r)\n", ruta);
+		return(1);
+		}
+	if((d = opendir(ruta)) == NULL)
+		{
+		fprintf(stderr,"No se puede leer %s\n", ruta);
+		return(1);
+		}
+	while((x = readdir(d)) != NULL)
+		{
+		if(strcmp(x->d_name, ".") == 0 || strcmp(x->d_name, "..") == 0)
+			{
+			continue;
+			}
+		sub = malloc(strlen(ruta) + strlen(x->d_name) + 2);
+		if(sub == NULL)
+			{
+			fprintf(stderr,"Error al asignar memoria\n");
+			exit(1);
+			}
+		sprintf(sub, "%s/%s", ruta, x->d_name);
+		err |= recorre(Li, sub, op, rec, 0);
+		free(sub);
+		}
+	closedir(d);
+	return(err);
+	}
+
+/*
+ * Function: abreSal()
+ *
+ * Purpose: Creates an output file, refusing to replace one unless forced
+ */
+static int abreSal(cad s, byte forzar)
+	{
+	return(open(s, O_RDWR | O_CREAT | (forzar ? O_TRUNC : O_EXCL), 0600));
+	}
+
+/*
+ * Function: procesaChico()
+ *
+ * Purpose: Encrypts, decrypts or re-keys a whole small file in memory
+ *
+ * Parameters:
+ *   - trabajo *J: Shared job
+ *   - arch *F: File
+ *   - bufs *W: Worker buffers
+ *
+ * Returns: void (failures are recorded in F->err)
+ */
+static void procesaChico(trabajo *J, arch *F, bufs *W)
+	{
+	contenedor C;
+	bytes sal;
+	uint64_t i;
+	size_t tS;
+	int fd;
+	byte err;
+
+	fd = open(F->e, O_RDONLY);
+	if(fd < 0)
+		{
+		F->err = 1;
+		return;
+		}
+	W->e = crece(W->e, &W->tE, F->tam + 1);
+	err = leeTodoEn(fd, W->e, F->tam, 0);
+	close(fd);
+	if(J->op == opCif)
+		{
+		ctnIni(&C, J->tSeg, F->tam, 0);
+		err |= nonPide(&W->R, C.nSeg, &C.base);
+		tS = ctnTam(&C);
+		}
+	else
+		{
+		err |= F->tam < ctnCab || ctnLeeCab(W->e, F->tam, &C) != 0;
+		tS = err ? 0 : J->op == opDes ? C.lon : F->tam;
+
+		// Re-keying leases a new base: every record is re-sealed under
+		// ctnNonce(base, i, 0) for the new key and the header takes it
+		err |= err == 0 && J->op == parRec && nonPide(&W->R, C.nSeg, &C.base) != 0;
+		}
+	if(err != 0 || (fd = abreSal(F->s, J->forzar)) < 0)
+		{
+		F->err = 1;
+		return;
+		}
+	W->B = crece(W->B, &W->tB, C.tSeg);
+
+	sal = NULL;
+	if(J->mmapS != 0 && tS > 0)
+		{
+		sal = ftruncate(fd, (off_t)tS) == 0 ? mmap(NULL, tS, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+		err = sal == MAP_FAILED;
+		}
+	if(sal == NULL)
+		{
+		W->s = crece(W->s, &W->tS, tS + 1);
+		sal = W->s;
+		}
+
+	if(err == 0 && J->op == opCif)
+		{
+		ctnPonCab(&C, sal);
+		for(i=0;i<C.nSeg;i++)
+			{
+			ctnCifraSeg(&J->L, &C, i, ctnNonce(&C, i, 0), W->e + i * C.tSeg, sal + ctnOff(&C, i), (bloques)W->B);
+			}
+		}
+	for(i=0;i<C.nSeg && err == 0 && J->op == opDes;i++)
+		{
+		err = ctnDescifraSeg(&J->L, &C, i, W->e + ctnOff(&C, i), sal + i * C.tSeg, (bloques)W->B);
+		}
+	if(err == 0 && J->op == parRec)
+		{
+		ctnPonCab(&C, sal);
+		for(i=0;i<C.nSeg && err == 0;i++)
+			{
+			err = ctnRecifraSeg(&J->L, &J->Ln, &C, i, ctnNonce(&C, i, 0), W->e + ctnOff(&C, i), sal + ctnOff(&C, i), (bloques)W->B);
+			}
+		}
+
+	if(sal != W->s)
+		{
+		if(sal != MAP_FAILED)
+			{
+			munmap(sal, tS);
+			}
+		}
+	else if(err == 0)
+		{
+		err = escTodo(fd, sal, tS);
+		}
+	// A re-keyed container replaces the original only once it is on disk
+	err |= J->op == parRec && err == 0 && fsync(fd) != 0;
+	err |= close(fd) != 0;
+	err |= J->op == parRec && err == 0 && rename(F->s, F->e) != 0;
+	if(err != 0)
+		{
+		unlink(F->s);
+		F->err = 1;
+		}
+	return;
+	}
+
+/*
+ * Function: preparaGrande()
+ *
+ * Purpose: Opens a large file and creates its sized output
+ *
+ * Parameters:
+ *   - trabajo *J: Shared job
+ *   - arch *F: File
+ *   - arriendo *R: Nonce lease of the main thread (encryption and
+ *                  re-keying)
+ *
+ * Returns:
+ *   - 0: Ready for segment tasks
+ *   - 1: Failed (F->err set; nothing to clean up but the descriptors)
+ */
+static byte preparaGrande(trabajo *J, arch *F, arriendo *R)
+	{
+	byte cab[ctnCab];
+
+	F->err = 1;
+	if((F->fdE = open(F->e, O_RDONLY)) < 0)
+		{
+		return(1);
+		}
+	if(J->op == opCif)
+		{
+		ctnIni(&F->C, J->tSeg, F->tam, 0);
+		if(nonPide(R, F->C.nSeg, &F->C.base) != 0)
+			{
+			return(1);
+			}
+		F->tS = ctnTam(&F->C);
+		}
+	else if(leeTodoEn(F->fdE, cab, ctnCab, 0) != 0 || ctnLeeCab(cab, F->tam, &F->C) != 0
+		|| (J->op == parRec && nonPide(R, F->C.nSeg, &F->C.base) != 0))
+		{
+		return(1);
+		}
+	else
+		{
+		F->tS = J->op == opDes ? F->C.lon : F->tam;
+		}
+	if((F->fdS = abreSal(F->s, J->forzar)) < 0)
+		{
+		return(1);
+		}
+	// From here on a failure must remove the output
+	F->err = 0;
+	if(ftruncate(F->fdS, (off_t)F->tS) != 0)
+		{
+		F->err = 1;
+		return(1);
+		}
+	if(J->mmapS != 0 && F->tS > 0)
+		{
+		F->mS = mmap(NULL, F->tS, PROT_READ | PROT_WRITE, MAP_SHARED, F->fdS, 0);
+		if(F->mS == MAP_FAILED)
+			{
+			F->mS = NULL;
+			F->err = 1;
+			return(1);
+			}
+		}
+	if(J->op != opDes)
+		{
+		ctnPonCab(&F->C, cab);
+		if(F->mS != NULL)
+			{
+			memcpy(F->mS, cab, ctnCab);
+			}
+		else
+			{
+			F->err = escTodoEn(F->fdS, cab, ctnCab, 0);
+			}
+		}
+	return(F->err);
+	}
+
+/*
+ * Function: procesaSegs()
+ *
+ * Purpose: Encrypts, decrypts or re-keys a range of segments of a large
+ *          file
+ *
+ * Parameters:
+ *   - trabajo *J: Shared job
+ *   - arch *F: File prepared by preparaGrande()
+ *   - tarea *t: Segment range
+ *   - bufs *W: Worker buffers
+ *
+ * Returns: void (failures are recorded in F->err)
+ */
+static void procesaSegs(trabajo *J, arch *F, tarea *t, bufs *W)
+	{
+	contenedor *C = &F->C;
+	uint64_t i;
+	uint64_t l;
+	size_t lr;
+	bytes x;
+	byte err = 0;
+
+	W->e = crece(W->e, &W->tE, ctnReg + C->tSeg);
+	W->s = crece(W->s, &W->tS, ctnReg + C->tSeg);
+	W->B = crece(W->B, &W->tB, C->tSeg);
+	for(i=t->s0;i<t->s1 && err == 0 && __atomic_load_n(&F->err, __ATOMIC_RELAXED) == 0;i++)
+		{
+		l = ctnLonSeg(C, i);
+		lr = ctnReg + (size_t)((l + n_8 - 1) / n_8) * n_8;
+		if(J->op == opCif)
+			{
+			x = F->mS != NULL ? F->mS + ctnOff(C, i) : W->s;
+			err = leeTodoEn(F->fdE, W->e, (size_t)l, i * C->tSeg);
+			if(err == 0)
+				{
+				ctnCifraSeg(&J->L, C, i, ctnNonce(C, i, 0), W->e, x, (bloques)W->B);
+				err = F->mS == NULL && escTodoEn(F->fdS, x, lr, ctnOff(C, i));
+				}
+			}
+		else if(J->op == parRec)
+			{
+			x = F->mS != NULL ? F->mS + ctnOff(C, i) : W->s;
+			err = leeTodoEn(F->fdE, W->e, lr, ctnOff(C, i))
+				|| ctnRecifraSeg(&J->L, &J->Ln, C, i, ctnNonce(C, i, 0), W->e, x, (bloques)W->B)
+				|| (F->mS == NULL && escTodoEn(F->fdS, x, lr, ctnOff(C, i)));
+			}
+		else
+			{
+			x = F->mS != NULL ? F->mS + i * C->tSeg : W->s;
+			err = leeTodoEn(F->fdE, W->e, lr, ctnOff(C, i))
+				|| ctnDescifraSeg(&J->L, C, i, W->e, x, (bloques)W->B)
+				|| (F->mS == NULL && escTodoEn(F->fdS, x, (size_t)l, i * C->tSeg));
+			}
+		}
+	if(err != 0)
+		{
+		__atomic_store_n(&F->err, 1, __ATOMIC_RELAXED);
+		}
+	return;
+	}
+
+/*
+ * Function: trabajador()
+ *
+ * Purpose: Worker thread, claims tasks until none are left
+ */
+static void * trabajador(void *x)
+	{
+	trabajo *J = x;
+	bufs W;
+	tarea *t;
+	size_t k;
+	size_t i;
+
+	memset(&W, 0, sizeof(bufs));
+	nonIniArr(&W.R, J->G);
+	while((k = __atomic_fetch_add(&J->sig, 1, __ATOMIC_RELAXED)) < J->nT)
+		{
+		t = &J->T[k];
+		if(t->nA == 0)
+			{
+			procesaSegs(J, &J->F[t->a], t, &W);
+			continue;
+			}
+		for(i=t->a;i<t->a+t->nA;i++)
+			{
+			procesaChico(J, &J->F[i], &W);
+			}
+		}
+	free(W.e);
+	free(W.s);
+	free(W.B);
+	return(NULL);
+	}
+
+/*
+ * Function: usoParalelo()
+ *
+ * Purpose: Prints the usage of the enc and dec subcommands
+ */
+static int usoParalelo()
+	{
+	fprintf(stderr,"Uso: cifrador enc|dec -k LLAVE [-N estado] [-j hilos] [-r] [-s bytes] [-w pwrite|mmap] [-f] RUTA...\n");
+	fprintf(stderr,"     cifrador rec -k LLAVE -K NUEVA [-N estado] [-j hilos] [-r] [-w pwrite|mmap] [-f] RUTA...\n");
+	fprintf(stderr,"     LLAVE, NUEVA: archivos con la llave en 32 digitos hex\n");
+	return(1);
+	}
+
+/*
+ * Function: paralelo()
+ *
+ * Purpose: Entry point of "cifrador enc", "cifrador dec" and "cifrador rec"
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "enc", "dec" or "rec")
+ *   - char *argv[]: Options and paths
+ *   - byte op: opCif, opDes or parRec
+ *
+ * Options:
+ *   - -k FILE:   Key file (required; the current key for rec)
+ *   - -K FILE:   New key file (rec only, required)
+ *   - -N FILE:   Nonce state file of the key containers are sealed
+ *                under (-k for enc, -K for rec); keeps segment nonces
+ *                unique across runs under that key (see nonces.c).
+ *                Without it each run starts at a random point
+ *   - -j N:      Worker threads (default: online CPUs)
+ *   - -r:        Walk directories recursively
+ *   - -s BYTES:  Segment size when encrypting (default 65536, multiple
+ *                of 8); decryption takes it from each container
+ *   - -w WRITER: "pwrite" (default) writes each segment from a buffer,
+ *                "mmap" encrypts straight into the mapped output
+ *   - -f:        Overwrite existing outputs (stale .tmp files for rec)
+ *
+ * Returns:
+ *   - int: 0 if every file succeeded, 1 otherwise
+ */
+int paralelo(int argc, char *argv[], byte op)
+	{
+	trabajo J;
+	lista Li = {NULL, 0, 0};
+	pthread_t h[parHilosMax];
+	size_t nH = (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+	size_t cap = 0;
+	size_t i;
+	size_t fallas = 0;
+	uint64_t s0;
+	uint64_t bytesLote = 0;
+	uint64_t tot = 0;
+	cad rutaK = NULL;
+	cad rutaKn = NULL;
+	cad rutaN = NULL;
+	gestorN G;
+	arriendo R;
+	bloque K[2];
+	byte rec = 0;
+	byte err = 0;
+	int opc;
+	double t0;
+
+	memset(&J, 0, sizeof(trabajo));
+	J.op	= op;
+	J.tSeg	= ctnSegDef;
+	optind = 1;
+	while((opc = getopt(argc, argv, "k:K:N:j:rs:w:f")) != -1)
+		{
+		switch(opc)
+			{
+			case 'k':
+				rutaK = optarg;
+				break;
+			case 'K':
+				rutaKn = optarg;
+				break;
+			case 'N':
+				rutaN = optarg;
+				break;
+			case 'j':
+				nH = strtoull(optarg, NULL, 10);
+				break;
+			case 'r':
+				rec = 1;
+				break;
+			case 's':
+				J.tSeg = (uint32_t)strtoul(optarg, NULL, 10);
+				break;
+			case 'w':
+				J.mmapS = strcmp(optarg, "mmap") == 0;
+				if(J.mmapS == 0 && strcmp(optarg, "pwrite") != 0)
+					{
+					return(usoParalelo());
+					}
+				break;
+			case 'f':
+				J.forzar = 1;
+				break;
+			default:
+				return(usoParalelo());
+			}
+		}
+	if(rutaK == NULL || (op == parRec) != (rutaKn != NULL) || optind >= argc || nH == 0 || J.tSeg == 0 || J.tSeg % n_8 != 0 || J.tSeg > ctnSegMax)
+		{
+		return(usoParalelo());
+		}
+	if(leeLlave(rutaK, K) != 0)
+		{
+		fprintf(stderr,"Llave invalida en %s\n", rutaK);
+		return(1);
+		}
+	expandeLlave(&J.L, K);
+	if(op == parRec)
+		{
+		if(leeLlave(rutaKn, K) != 0)
+			{
+			fprintf(stderr,"Llave invalida en %s\n", rutaKn);
+			return(1);
+			}
+		expandeLlave(&J.Ln, K);
+		}
+	nH = nH > parHilosMax ? parHilosMax : nH;
+
+	// Segment nonces: 48-bit ranges leased per thread; without a state
+	// file the run starts at a random point of the lower half
+	if(nonAbre(&G, op != opDes ? rutaN : NULL, ctnAleat() >> 1, ctnBaseMsk + 1) != 0)
+		{
+		fprintf(stderr,"Estado de nonces invalido en %s\n", rutaN);
+		return(1);
+		}
+	J.G = &G;
+	nonIniArr(&R, &G);
+
+	for(i=optind;(int)i<argc;i++)
+		{
+		err |= recorre(&Li, argv[i], op, rec, 1);
+		}
+	J.F	= Li.F;
+	J.nF	= Li.num;
+
+	// Tasks: batches of consecutive small files, segment ranges of large ones
+	for(i=0;i<J.nF;i++)
+		{
+		if(J.nT + 1 >= cap)
+			{
+			cap = cap ? cap << 1 : 0x100;
+			J.T = realloc(J.T, cap * sizeof(tarea));
+			if(J.T == NULL)
+				{
+				fprintf(stderr,"Error al asignar memoria\n");
+				exit(1);
+				}
+			}
+		tot += J.F[i].tam;
+		if(J.F[i].tam <= parLoteTam)
+			{
+			if(J.nT == 0 || J.T[J.nT-1].a + J.T[J.nT-1].nA != i || J.T[J.nT-1].nA == parLoteMax
+				|| bytesLote + J.F[i].tam > parLoteTam)
+				{
+				J.T[J.nT].a = i;
+				J.T[J.nT].nA = 0;
+				J.nT++;
+				bytesLote = 0;
+				}
+			J.T[J.nT-1].nA++;
+			bytesLote += J.F[i].tam;
+			continue;
+			}
+		if(preparaGrande(&J, &J.F[i], &R) != 0)
+			{
+			continue;
+			}
+		for(s0=0;s0<J.F[i].C.nSeg;s0+=parSegTarea)
+			{
+			if(J.nT + 1 >= cap)
+				{
+				cap <<= 1;
+				J.T = realloc(J.T, cap * sizeof(tarea));
+				if(J.T == NULL)
+					{
+					fprintf(stderr,"Error al asignar memoria\n");
+					exit(1);
+					}
+				}
+			J.T[J.nT].a	= i;
+			J.T[J.nT].nA	= 0;
+			J.T[J.nT].s0	= s0;
+			J.T[J.nT].s1	= s0 + parSegTarea < J.F[i].C.nSeg ? s0 + parSegTarea : J.F[i].C.nSeg;
+			J.nT++;
+			}
+		}
+
+	t0 = metReloj();
+	nH = nH > J.nT ? J.nT : nH;
+	for(i=0;i<nH;i++)
+		{
+		if(pthread_create(&h[i], NULL, trabajador, &J) != 0)
+			{
+			nH = i;
+			break;
+			}
+		}
+	if(nH == 0 && J.nT > 0)
+		{
+		trabajador(&J);
+		}
+	for(i=0;i<nH;i++)
+		{
+		pthread_join(h[i], NULL);
+		}
+	t0 = metReloj() - t0;
+
+	for(i=0;i<J.nF;i++)
+		{
+		if(J.F[i].mS != NULL)
+			{
+			munmap(J.F[i].mS, J.F[i].tS);
+			}
+		if(J.F[i].fdE >= 0)
+			{
+			close(J.F[i].fdE);
+			}
+		if(J.F[i].fdS >= 0 && J.op == parRec && J.F[i].err == 0 && fsync(J.F[i].fdS) != 0)
+			{
+			J.F[i].err = 1;
+			}
+		if(J.F[i].fdS >= 0 && close(J.F[i].fdS) != 0)
+			{
+			J.F[i].err = 1;
+			}
+		if(J.F[i].fdS >= 0 && J.op == parRec && J.F[i].err == 0 && rename(J.F[i].s, J.F[i].e) != 0)
+			{
+			J.F[i].err = 1;
+			}
+		if(J.F[i].err != 0)
+			{
+			if(J.F[i].fdS >= 0)
+				{
+				unlink(J.F[i].s);
+				}
+			fprintf(stderr,"Error: %s\n", J.F[i].e);
+			fallas++;
+			}
+		free(J.F[i].e);
+		free(J.F[i].s);
+		}
+	fprintf(stderr,"%zu archivos, %zu con error, %.1f MB en %.3f s (%.2f MB/s, %zu hilos)\n",
+		J.nF, fallas, (double)tot * 1e-6, t0, t0 > 0 ? (double)tot * 1e-6 / t0 : 0, nH);
+	free(J.F);
+	free(J.T);
+	nonCierra(&G);
+	return(err != 0 || fallas != 0);
+	}
+
+/*
+ * Function: actSeg()
+ *
+ * Purpose: Rewrites one segment affected by an update
+ *
+ * Parameters:
+ *   - actual *A: Update in progress
+ *   - uint64_t i: Segment index
+ *   - bufs *W: Worker buffers
+ *
+ * Returns:
+ *   - 0: Record rewritten
+ *   - 1: I/O error, old record not verified or write counter exhausted
+ *
+ * Details: A segment fully covered by the new bytes is not decrypted;
+ *          only its nonce is read to continue the counter. An existing
+ *          record keeps the segment bits of its stored nonce and takes
+ *          the next counter value; a new segment takes the next nonce of
+ *          the run leased for the growth (A->base), counter 0
+ */
+static byte actSeg(actual *A, uint64_t i, bufs *W)
+	{
+	uint64_t p0 = i * A->C.tSeg;
+	uint64_t l = ctnLonSeg(&A->C, i);
+	uint64_t lv;
+	uint64_t ctr;
+	uint64_t x0;
+	uint64_t x1;
+	bloque N = (A->base + (i - A->V.nSeg)) & ctnBaseMsk;
+
+	if(i < A->V.nSeg)
+		{
+		lv = ctnLonSeg(&A->V, i);
+		if(A->off <= p0 && A->off + A->t >= p0 + l)
+			{
+			if(leeTodoEn(A->fd, W->e, n_8, ctnOff(&A->V, i)) != 0)
+				{
+				return(1);
+				}
+			}
+		else if(leeTodoEn(A->fd, W->e, ctnReg + (size_t)((lv + n_8 - 1) / n_8) * n_8, ctnOff(&A->V, i)) != 0
+			|| ctnDescifraSeg(A->L, &A->V, i, W->e, W->s, (bloques)W->B) != 0)
+			{
+			return(1);
+			}
+		N = cargaBE(W->e);
+		ctr = N >> ctnCtrDes;
+		if(ctr == ctnCtrMax)
+			{
+			return(1);
+			}
+		N = ((ctr + 1) << ctnCtrDes) | (N & ctnBaseMsk);
+		}
+
+	// Merge the written bytes that fall in this segment
+	x0 = A->off > p0 ? A->off : p0;
+	x1 = A->off + A->t < p0 + l ? A->off + A->t : p0 + l;
+	if(x1 > x0)
+		{
+		memcpy(W->s + (x0 - p0), A->d + (x0 - A->off), (size_t)(x1 - x0));
+		}
+	ctnCifraSeg(A->L, &A->C, i, N, W->s, W->e, (bloques)W->B);
+	return(escTodoEn(A->fd, W->e, ctnReg + (size_t)((l + n_8 - 1) / n_8) * n_8, ctnOff(&A->C, i)));
+	}
+
+/*
+ * Function: actTrabajador()
+ *
+ * Purpose: Update worker, claims groups of parSegTarea segments
+ */
+static void * actTrabajador(void *x)
+	{
+	actual *A = x;
+	bufs W;
+	uint64_t k;
+	uint64_t i;
+
+	memset(&W, 0, sizeof(bufs));
+	W.e = crece(W.e, &W.tE, ctnReg + A->C.tSeg);
+	W.s = crece(W.s, &W.tS, A->C.tSeg);
+	W.B = crece(W.B, &W.tB, A->C.tSeg);
+	while((k = A->s0 + __atomic_fetch_add(&A->sig, 1, __ATOMIC_RELAXED) * parSegTarea) < A->s1)
+		{
+		for(i=k;i<k+parSegTarea && i<A->s1 && __atomic_load_n(&A->err, __ATOMIC_RELAXED) == 0;i++)
+			{
+			if(actSeg(A, i, &W) != 0)
+				{
+				__atomic_store_n(&A->err, 1, __ATOMIC_RELAXED);
+				}
+			}
+		}
+	free(W.e);
+	free(W.s);
+	free(W.B);
+	return(NULL);
+	}
+
+/*
+ * Function: parActualiza()
+ *
+ * Purpose: Writes a byte range into a container in place
+ *
+ * Parameters:
+ *   - cad ruta: Container path
+ *   - llaveExp *L: Expanded key
+ *   - arriendo *R: Nonce lease for the key, used only for the segments
+ *                  an update adds
+ *   - uint64_t off: Plaintext offset of the range (at most the current
+ *                   length; writing past the end extends the file)
+ *   - bytes d: New bytes
+ *   - uint64_t t: Number of new bytes
+ *   - size_t nH: Worker threads
+ *
+ * Returns:
+ *   - 0: Range written and synced
+ *   - 1: Invalid container or offset, unverified segment, exhausted
+ *        write counter, nonce space exhausted or I/O error
+ *
+ * Details:
+ *   - Affected segments are those overlapping [off, off + t), plus the
+ *     old last segment when the file grows, since its length and last
+ *     flag are authenticated
+ *   - Each rewritten record takes the next value of its 16-bit write
+ *     counter, so no nonce is reused; a segment can be rewritten
+ *     ctnCtrMax times
+ *   - Only nSeg nonces were leased for the container (base + nSeg is
+ *     the next container's), so an update adding segments leases a run
+ *     for the added ones only. The header keeps its base; every record
+ *     carries its own nonce, so the tail needs no relation to it
+ *   - The container has no index over the records: the tag of each
+ *     record is the only entry that changes
+ *   - The key is checked on the last segment first, since segments
+ *     fully covered by the range are rewritten without being decrypted
+ *   - An update is not atomic; an interrupted update can leave some
+ *     segments rewritten. Use a copy (as rec does) when that matters.
+ */
+byte parActualiza(cad ruta, llaveExp *L, arriendo *R, uint64_t off, bytes d, uint64_t t, size_t nH)
+	{
+	actual A;
+	pthread_t h[parHilosMax];
+	struct stat st;
+	bufs W;
+	byte cab[ctnCab];
+	size_t i;
+	uint64_t u;
+	int fd;
+
+	memset(&A, 0, sizeof(actual));
+	if((fd = open(ruta, O_RDWR)) < 0)
+		{
+		return(1);
+		}
+	A.fd	= fd;
+	A.L	= L;
+	A.off	= off;
+	A.d	= d;
+	A.t	= t;
+	if(fstat(fd, &st) != 0 || leeTodoEn(fd, cab, ctnCab, 0) != 0 || ctnLeeCab(cab, (uint64_t)st.st_size, &A.V) != 0
+		|| off > A.V.lon)
+		{
+		close(fd);
+		return(1);
+		}
+	if(t == 0)
+		{
+		return(close(fd) != 0);
+		}
+
+	// Fully overwritten segments are not decrypted: check the key on the
+	// last segment before anything is written
+	memset(&W, 0, sizeof(bufs));
+	u = A.V.nSeg - 1;
+	W.e = crece(W.e, &W.tE, ctnReg + A.V.tSeg);
+	W.s = crece(W.s, &W.tS, A.V.tSeg);
+	W.B = crece(W.B, &W.tB, A.V.tSeg);
+	A.err = leeTodoEn(fd, W.e, ctnReg + (size_t)((ctnLonSeg(&A.V, u) + n_8 - 1) / n_8) * n_8, ctnOff(&A.V, u)) != 0
+		|| ctnDescifraSeg(L, &A.V, u, W.e, W.s, (bloques)W.B) != 0;
+	free(W.e);
+	free(W.s);
+	free(W.B);
+	if(A.err != 0)
+		{
+		close(fd);
+		return(1);
+		}
+
+	ctnIni(&A.C, A.V.tSeg, off + t > A.V.lon ? off + t : A.V.lon, A.V.base);
+	A.s0 = off / A.C.tSeg;
+	A.s1 = (off + t - 1) / A.C.tSeg + 1;
+
+	// The old last segment loses its last flag or its length changes;
+	// added segments take a run of nonces of their own
+	if(A.C.lon != A.V.lon)
+		{
+		A.s0 = A.s0 < A.V.nSeg - 1 ? A.s0 : A.V.nSeg - 1;
+		}
+	if(A.C.nSeg > A.V.nSeg && nonPide(R, A.C.nSeg - A.V.nSeg, &A.base) != 0)
+		{
+		close(fd);
+		return(1);
+		}
+	if(A.C.lon != A.V.lon && ftruncate(fd, (off_t)ctnTam(&A.C)) != 0)
+		{
+		A.err = 1;
+		A.s1 = A.s0;
+		}
+
+	nH = nH > parHilosMax ? parHilosMax : nH;
+	nH = nH > (A.s1 - A.s0 + parSegTarea - 1) / parSegTarea ? (A.s1 - A.s0 + parSegTarea - 1) / parSegTarea : nH;
+	for(i=0;i<nH;i++)
+		{
+		if(pthread_create(&h[i], NULL, actTrabajador, &A) != 0)
+			{
+			nH = i;
+			break;
+			}
+		}
+	if(nH == 0)
+		{
+		actTrabajador(&A);
+		}
+	for(i=0;i<nH;i++)
+		{
+		pthread_join(h[i], NULL);
+		}
+
+	if(A.err == 0 && A.C.lon != A.V.lon)
+		{
+		ctnPonCab(&A.C, cab);
+		A.err = escTodoEn(fd, cab, ctnCab, 0);
+		}
+	A.err |= fsync(fd) != 0;
+	A.err |= close(fd) != 0;
+	return(A.err != 0);
+	}
+
+/*
+ * Function: actualiza()
+ *
+ * Purpose: Entry point of "cifrador act"
+ *
+ * Parameters:
+ *   - int argc: Argument count (argv[0] is "act")
+ *   - char *argv[]: Options and the container path
+ *
+ * Options:
+ *   - -k FILE:   Key file (required)
+ *   - -o OFFSET: Plaintext offset of the new bytes (required)
+ *   - -i FILE:   New bytes (default: standard input)
+ *   - -N FILE:   Nonce state file of the key, used when the container
+ *                grows by whole segments (as for enc)
+ *   - -j N:      Worker threads (default: online CPUs)
+ *
+ * Returns:
+ *   - int: 0 on success, 1 otherwise
+ */
+int actualiza(int argc, char *argv[])
+	{
+	llaveExp L;
+	bloque K[2];
+	bytes d = NULL;
+	size_t cap = 0;
+	size_t t = 0;
+	size_t l;
+	size_t nH = (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+	uint64_t off = 0;
+	cad rutaK = NULL;
+	cad rutaD = NULL;
+	cad rutaN = NULL;
+	gestorN G;
+	arriendo R;
+	byte hayOff = 0;
+	byte err;
+	int fd = STDIN_FILENO;
+	int opc;
+	double t0;
+
+	optind = 1;
+	while((opc = getopt(argc, argv, "k:o:i:N:j:")) != -1)
+		{
+		switch(opc)
+			{
+			case 'k':
+				rutaK = optarg;
+				break;
+			case 'o':
+				off = strtoull(optarg, NULL, 0);
+				hayOff = 1;
+				break;
+			case 'i':
+				rutaD = optarg;
+				break;
+			case 'N':
+				rutaN = optarg;
+				break;
+			case 'j':
+				nH = strtoull(optarg, NULL, 10);
+				break;
+			default:
+				optind = argc;
+				break;
+			}
+		}
+	if(rutaK == NULL || hayOff == 0 || optind + 1 != argc)
+		{
+		fprintf(stderr,"Uso: cifrador act -k LLAVE -o DESPLAZAMIENTO [-i DATOS] [-N estado] [-j hilos] CONTENEDOR\n");
+		return(1);
+		}
+	if(leeLlave(rutaK, K) != 0)
+		{
+		fprintf(stderr,"Llave invalida en %s\n", rutaK);
+		return(1);
+		}
+	expandeLlave(&L, K);
+
+	if(rutaD != NULL && (fd = open(rutaD, O_RDONLY)) < 0)
+		{
+		fprintf(stderr,"No se puede leer %s\n", rutaD);
+		return(1);
+		}
+	do
+		{
+		d = crece(d, &cap, cap ? cap << 1 : arcTrozo);
+		l = leeTodo(fd, d + t, cap - t);
+		t += l;
+		}
+	while(t == cap);
+	if(fd != STDIN_FILENO)
+		{
+		close(fd);
+		}
+
+	if(nonAbre(&G, rutaN, ctnAleat() >> 1, ctnBaseMsk + 1) != 0)
+		{
+		fprintf(stderr,"Estado de nonces invalido en %s\n", rutaN);
+		free(d);
+		return(1);
+		}
+	nonIniArr(&R, &G);
+	t0 = metReloj();
+	err = parActualiza(argv[optind], &L, &R, off, d, t, nH);
+	t0 = metReloj() - t0;
+	nonCierra(&G);
+	if(err != 0)
+		{
+		fprintf(stderr,"Error al actualizar %s\n", argv[optind]);
+		}
+	else
+		{
+		fprintf(stderr,"%zu bytes escritos en %.3f s\n", t, t0);
+		}
+	free(d);
+	return(err);
+	}
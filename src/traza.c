@@ -0,0 +1,450 @@
+/*
+ * ============================================================================
+ * File: traza.c
+ * Purpose: Compact binary capture of COFB operation metadata
+ *
+ * This file implements:
+ * - Pseudonymous key handles (Midori-64 of a per-capture salt under the
+ *   key, never the key itself)
+ * - Optional FNV-1a hashes of the input payload instead of the data
+ * - Append-only encoding of one record per operation
+ * - Loading of a complete trace for replay
+ *
+ * File Format (all fixed-width integers big-endian):
+ *   Header: "CFBT" | version (1 byte) | salt (8)
+ *   Record: op (1) | flags (1) | arrival ns (8) | key handle (8) |
+ *           AD blocks (varint) | message blocks (varint) |
+ *           service ns (varint) | [payload hash (8) if flags & trzConH]
+ *
+ *   Varints use LEB128 (7 bits per byte, low group first).
+ *   The salt is drawn once when the file is created and reused by every
+ *   process appending to it, so handles are stable within a capture and
+ *   unrelated across captures. Version 1 traces (no salt, unkeyed FNV-1a
+ *   handles) can still be replayed but are no longer appended to.
+ *   Arrival times are absolute CLOCK_REALTIME values, so traces appended
+ *   by several short-lived processes keep their relative spacing.
+ *
+ * Author: COFB-Midori64 Project
+ * Date: December 2025
+ * ============================================================================
+ */
+
+#include"traza.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+
+#define fnvBase	0xcbf29ce484222325	//base de FNV-1a de 64 bits
+#define fnvPrim	0x00000100000001b3	//primo de FNV-1a de 64 bits
+
+/*
+ * Capture State
+ *
+ * trzHash:  non-zero when payload hashes must be accumulated
+ * trzAcumH: running hash of the operation currently in progress
+ * trzSal:   salt of the open capture, set by trzAbrir()
+ */
+byte	trzHash = 0;
+bloque	trzAcumH = fnvBase;
+bloque	trzSal = 0;
+
+/*
+ * Function: trzReloj()
+ *
+ * Purpose: Reads the wall clock used for record arrival times
+ *
+ * Returns:
+ *   - uint64_t: Nanoseconds since the epoch (CLOCK_REALTIME)
+ */
+uint64_t trzReloj()
+	{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return((uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec);
+	}
+
+/*
+ * Function: trzFnv()
+ *
+ * Purpose: Folds one 64-bit block into an FNV-1a hash
+ *
+ * Parameters:
+ *   - bloque h: Current hash value
+ *   - bloque B: Block to absorb (most significant byte first)
+ *
+ * Returns:
+ *   - bloque: Updated hash value
+ */
+bloque trzFnv(bloque h, bloque B)
+	{
+	byte i;
+
+	for(i=0;i<n_8;i++)
+		{
+		h ^= (B >> (0x38 - (i<<3))) & 0xff;
+		h *= fnvPrim;
+		}
+	return(h);
+	}
+
+/*
+ * Function: trzLlave()
+ *
+ * Purpose: Derives a pseudonymous handle that identifies a key in traces
+ *
+ * Parameters:
+ *   - bloques K: 128-bit key (array of 2 blocks)
+ *
+ * Returns:
+ *   - bloque: The capture salt (trzSal) encrypted under K
+ *
+ * Details: Equal keys map to equal handles within a capture, which is
+ *          all replay needs to reproduce key-switching patterns. Going
+ *          back from a handle to the key is a key recovery on Midori-64,
+ *          and the fresh salt of each capture keeps handles of the same
+ *          key unlinkable across traces
+ */
+bloque trzLlave(bloques K)
+	{
+	return(midori(trzSal,K,0));
+	}
+
+/*
+ * Function: trzAcum()
+ *
+ * Purpose: Adds one input block to the payload hash when enabled
+ *
+ * Parameters:
+ *   - bloque B: Plaintext (encryption) or ciphertext (decryption) block
+ *
+ * Returns: void
+ */
+void trzAcum(bloque B)
+	{
+	if(trzHash != 0)
+		{
+		trzAcumH = trzFnv(trzAcumH, B);
+		}
+	return;
+	}
+
+/*
+ * Function: trzAbrir()
+ *
+ * Purpose: Opens a trace file for appending, creating it if needed
+ *
+ * Parameters:
+ *   - cad ruta: Path of the trace file
+ *
+ * Returns:
+ *   - int: File descriptor opened with O_APPEND, or -1 on error (also
+ *          for a file that is not a version 2 trace)
+ *
+ * Details: An empty file gets a header with a fresh random salt; an
+ *          existing one lends its salt, so every appender of a capture
+ *          derives the same handles. Either way trzSal is set. The check
+ *          and the header write run under flock(), so concurrent first
+ *          appenders agree on one header
+ */
+int trzAbrir(cad ruta)
+	{
+	int fd;
+	struct stat st;
+	byte cab[trzCab] = {'C','F','B','T',trzVer};
+	byte err;
+
+	fd = open(ruta, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if(fd < 0)
+		{
+		return(-1);
+		}
+
+	// Held from the size check to the header write, so two processes
+	// creating the same trace cannot both see it empty
+	if(flock(fd, LOCK_EX) != 0 || fstat(fd,&st) != 0)
+		{
+		close(fd);
+		return(-1);
+		}
+	if(st.st_size == 0)
+		{
+		err = getrandom(&trzSal, sizeof(trzSal), 0) != sizeof(trzSal);
+		guardaBE(cab + trzCab1, trzSal);
+		err = err || write(fd,cab,trzCab) != trzCab;
+		}
+	else
+		{
+		err = pread(fd,cab,trzCab,0) != trzCab || memcmp(cab,trzMagia,4) != 0 || cab[4] != trzVer;
+		trzSal = cargaBE(cab + trzCab1);
+		}
+	flock(fd, LOCK_UN);
+	if(err != 0)
+		{
+		close(fd);
+		return(-1);
+		}
+	return(fd);
+	}
+
+/*
+ * Function: trzIni()
+ *
+ * Purpose: Starts a record for an operation about to run
+ *
+ * Parameters:
+ *   - registro *R: Record to initialize
+ *   - byte op: Operation type (opCif or opDes)
+ *   - bloques K: Key used by the operation
+ *
+ * Returns: void
+ *
+ * Details: Block counts are snapshotted from the calling thread's
+ *          metrics counters and turned into per-operation deltas by
+ *          trzFin(), so operations on other threads do not leak in
+ */
+void trzIni(registro *R, byte op, bloques K)
+	{
+	R->op	= op;
+	R->band	= trzHash != 0 ? trzConH : 0;
+	R->llave = trzLlave(K);
+	R->a	= metPropias()->bloqA[op];
+	R->m	= metPropias()->bloqM[op];
+	R->hash	= 0;
+	trzAcumH = fnvBase;
+	R->t	= trzReloj();
+	return;
+	}
+
+/*
+ * Function: ponVar()
+ *
+ * Purpose: Encodes an unsigned integer as a LEB128 varint
+ *
+ * Parameters:
+ *   - bytes p: Destination buffer (at least 10 bytes)
+ *   - uint64_t v: Value to encode
+ *
+ * Returns:
+ *   - byte: Number of bytes written
+ */
+static byte ponVar(bytes p, uint64_t v)
+	{
+	byte l = 0;
+
+	while(v >= 0x80)
+		{
+		p[l++] = (byte)(v | 0x80);
+		v >>= 7;
+		}
+	p[l++] = (byte)v;
+	return(l);
+	}
+
+/*
+ * Function: pon64()
+ *
+ * Purpose: Stores a 64-bit integer in big-endian order
+ *
+ * Parameters:
+ *   - bytes p: Destination buffer (8 bytes)
+ *   - uint64_t v: Value to store
+ *
+ * Returns:
+ *   - byte: Number of bytes written (always 8)
+ */
+static byte pon64(bytes p, uint64_t v)
+	{
+	guardaBE(p, v);
+	return(n_8);
+	}
+
+/*
+ * Function: trzFin()
+ *
+ * Purpose: Completes a record and appends it to the trace
+ *
+ * Parameters:
+ *   - int fd: Descriptor returned by trzAbrir()
+ *   - registro *R: Record started with trzIni()
+ *
+ * Returns:
+ *   - 0: Record appended
+ *   - 1: Write error
+ *
+ * Details: Each record is emitted with a single write() on an O_APPEND
+ *          descriptor, so concurrent writers never interleave records
+ */
+byte trzFin(int fd, registro *R)
+	{
+	byte buf[trzMaxReg];
+	byte l = 0;
+
+	R->dur	= trzReloj() - R->t;
+	R->a	= metPropias()->bloqA[R->op] - R->a;
+	R->m	= metPropias()->bloqM[R->op] - R->m;
+	R->hash	= (R->band & trzConH) ? trzAcumH : 0;
+
+	buf[l++] = R->op;
+	buf[l++] = R->band;
+	l += pon64(buf+l, R->t);
+	l += pon64(buf+l, R->llave);
+	l += ponVar(buf+l, R->a);
+	l += ponVar(buf+l, R->m);
+	l += ponVar(buf+l, R->dur);
+	if(R->band & trzConH)
+		{
+		l += pon64(buf+l, R->hash);
+		}
+
+	return(write(fd,buf,l) != l);
+	}
+
+/*
+ * Function: leeVar()
+ *
+ * Purpose: Decodes a LEB128 varint
+ *
+ * Parameters:
+ *   - bytes p: Encoded data
+ *   - size_t *i: Read position, advanced past the varint
+ *   - size_t t: Size of the encoded data
+ *   - uint64_t *v: Decoded value (output)
+ *
+ * Returns:
+ *   - 0: Value decoded
+ *   - 1: Truncated or overlong varint
+ */
+static byte leeVar(bytes p, size_t *i, size_t t, uint64_t *v)
+	{
+	byte des = 0;
+
+	*v = 0;
+	while(*i < t && des < n_1)
+		{
+		*v |= (uint64_t)(p[*i] & 0x7f) << des;
+		if((p[(*i)++] & 0x80) == 0)
+			{
+			return(0);
+			}
+		des += 7;
+		}
+	return(1);
+	}
+
+/*
+ * Function: lee64()
+ *
+ * Purpose: Loads a big-endian 64-bit integer
+ *
+ * Parameters:
+ *   - bytes p: Encoded data
+ *   - size_t *i: Read position, advanced by 8
+ *
+ * Returns:
+ *   - uint64_t: Decoded value
+ */
+static uint64_t lee64(bytes p, size_t *i)
+	{
+	uint64_t v = cargaBE(p + *i);
+
+	*i += n_8;
+	return(v);
+	}
+
+/*
+ * Function: trzLeer()
+ *
+ * Purpose: Loads every record of a trace file
+ *
+ * Parameters:
+ *   - cad ruta: Path of the trace file
+ *   - size_t *t: Number of records loaded (output)
+ *
+ * Returns:
+ *   - registro *: Array of records (caller frees), or NULL on error
+ *
+ * Details: A truncated final record (e.g. from a crashed writer) is
+ *          ignored; any other malformed data rejects the file. Version 1
+ *          files are accepted too, their header has no salt
+ */
+registro * trzLeer(cad ruta, size_t *t)
+	{
+	FILE *f;
+	bytes buf;
+	long tam;
+	size_t i;
+	size_t cap = 0x100;
+	registro *R;
+	registro *tmp;
+	registro x;
+
+	*t = 0;
+	f = fopen(ruta,"rb");
+	if(f == NULL)
+		{
+		return(NULL);
+		}
+	fseek(f,0,SEEK_END);
+	tam = ftell(f);
+	rewind(f);
+
+	buf = malloc(tam > 0 ? tam : 1);
+	R = malloc(cap * sizeof(registro));
+	if(buf == NULL || R == NULL || tam < trzCab1 || fread(buf,1,tam,f) != (size_t)tam
+		|| memcmp(buf,trzMagia,4) != 0 || (buf[4] != trzVer && buf[4] != trzVer1)
+		|| (buf[4] == trzVer && tam < trzCab))
+		{
+		fclose(f);
+		free(buf);
+		free(R);
+		return(NULL);
+		}
+	fclose(f);
+
+	i = buf[4] == trzVer ? trzCab : trzCab1;
+	while(i + 0x14 < (size_t)tam)
+		{
+		x.op	= buf[i++];
+		x.band	= buf[i++];
+		x.t	= lee64(buf,&i);
+		x.llave	= lee64(buf,&i);
+		if(leeVar(buf,&i,tam,&x.a) || leeVar(buf,&i,tam,&x.m) || leeVar(buf,&i,tam,&x.dur))
+			{
+			break;
+			}
+		x.hash = 0;
+		if(x.band & trzConH)
+			{
+			if(i + n_8 > (size_t)tam)
+				{
+				break;
+				}
+			x.hash = lee64(buf,&i);
+			}
+		if(x.op >= nOps)
+			{
+			free(buf);
+			free(R);
+			return(NULL);
+			}
+		if(*t == cap)
+			{
+			cap <<= 1;
+			tmp = realloc(R, cap * sizeof(registro));
+			if(tmp == NULL)
+				{
+				free(buf);
+				free(R);
+				return(NULL);
+				}
+			R = tmp;
+			}
+		R[(*t)++] = x;
+		}
+
+	free(buf);
+	return(R);
+	}